@@ -61,9 +61,10 @@ namespace libthreadar
         }
     }
 #else
-    barrier::barrier(unsigned int num): val(num), cond(1)
+    barrier::barrier(unsigned int num): val(num), waiting_num(0), cond(1)
     {
-	    //nothing to do here
+	arrived = 0;
+	generation = 0;
     }
 #endif
 
@@ -123,10 +124,28 @@ namespace libthreadar
 	    cond.lock();
 	    try
 	    {
-		if(cond.get_waiting_thread_count() + 1 < val)
-		    cond.wait();
+		if(++arrived < val)
+		{
+		    unsigned int gen = generation;
+
+		    try
+		    {
+			while(gen == generation)
+			    cond.wait();
+		    }
+		    catch(...)
+		    {
+			if(gen == generation)
+			    --arrived;
+			throw;
+		    }
+		}
 		else
+		{
+		    arrived = 0;
+		    ++generation;
 		    cond.broadcast();
+		}
 	    }
 	    catch(...)
 	    {
@@ -37,7 +37,7 @@ extern "C"
 #endif
 }
     // C++ standard headers
-
+#include <atomic>
 
     // libthreadar headers
 #include "condition.hpp"
@@ -53,6 +53,8 @@ namespace libthreadar
         /// new cycle.
         /// \note The barrier shall not be destroyed if at least one thread
         /// is waiting (locked) on it
+        /// \note see also spin_barrier and tree_barrier for barriers
+        /// separating short computation phases
     class barrier
     {
     public:
@@ -65,13 +67,13 @@ namespace libthreadar
         barrier(const barrier & ref) = delete;
 
             /// no move constructor
-        barrier(barrier && ref) noexcept = default;
+        barrier(barrier && ref) = delete;
 
             /// no assignment operator
         barrier & operator = (const barrier & ref) = delete;
 
             /// no move operator
-        barrier & operator = (barrier && ref) noexcept = default;
+        barrier & operator = (barrier && ref) = delete;
 
             /// The destructor
 
@@ -92,7 +94,7 @@ namespace libthreadar
 	    /// \note this is to be seen as an approximation as a thread can be about to
 	    /// be suspended but not yet counted, as well as a thread may be just released
 	    /// while not yet removed from the count
-	unsigned int get_waiting_count() const { return waiting_num; };
+	unsigned int get_waiting_count() const { return waiting_num.load(std::memory_order_relaxed); };
 
 	static std::string used_implementation()
 	{
@@ -105,12 +107,14 @@ namespace libthreadar
 
     private:
 	unsigned int val;
-	unsigned int waiting_num;
+	std::atomic<unsigned int> waiting_num; ///< modified concurrently by the threads calling wait()
 
 #if HAVE_PTHREAD_BARRIER_T
 	pthread_barrier_t bar;
 #else
 	condition cond;
+	unsigned int arrived;    ///< number of threads that reached the barrier for the current generation
+	unsigned int generation; ///< incremented each time the barrier releases the waiting threads
 #endif
     };
 
@@ -0,0 +1,293 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+#if HAVE_SCHED_H
+#include <sched.h>
+#endif
+}
+    // C++ standard headers
+#include <new>
+#include <vector>
+
+    // libthreadar headers
+#include "condition.hpp"
+#include "thread.hpp"
+
+    // this module's header
+#include "cancellation_token.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+    thread_local cancellation_token::state *cancellation_token::current_state = nullptr;
+
+    cancellation_token::cancellation_token()
+    {
+	st.reset(new (nothrow) state());
+	if(! st)
+	    throw exception_memory();
+    }
+
+    void cancellation_token::cancel()
+    {
+	if(! st)
+	    throw THREADAR_BUG;
+	cancel_state(st);
+    }
+
+    cancellation_token cancellation_token::make_child() const
+    {
+	cancellation_token ret;
+
+	if(! st)
+	    throw THREADAR_BUG;
+
+	st->control.lock();
+	try
+	{
+	    list<weak_ptr<state> >::iterator it = st->children.begin();
+
+		// forgetting children that do no more exist
+	    while(it != st->children.end())
+	    {
+		if(it->expired())
+		    it = st->children.erase(it);
+		else
+		    ++it;
+	    }
+
+	    if(st->cancelled.load())
+		ret.st->cancelled.store(true);
+	    else
+		st->children.push_back(ret.st);
+	}
+	catch(...)
+	{
+	    st->control.unlock();
+	    throw;
+	}
+	st->control.unlock();
+
+	return ret;
+    }
+
+    cancellation_token cancellation_token::current()
+    {
+	cancellation_token ret(nullptr);
+
+	if(current_state != nullptr)
+	    ret.st = current_state->shared_from_this();
+	else
+	    ret = cancellation_token();
+
+	return ret;
+    }
+
+    cancellation_token::scope::scope(const cancellation_token & token)
+    {
+	previous = current_state;
+	if(token.st)
+	    current_state = token.st.get();
+    }
+
+    cancellation_token::scope::~scope()
+    {
+	current_state = previous;
+    }
+
+    cancellation_token::wait_registration::wait_registration(void *cond,
+							     wake_function wake,
+							     unsigned int instance,
+							     const cancellation_token *token)
+    {
+	cur = current_state;
+	tok = token != nullptr ? token->st.get() : nullptr;
+	if(tok == cur)
+	    tok = nullptr;
+	registered = false;
+
+	if(cur != nullptr)
+	    cur_ref = add_wait(cur, cond, wake, instance);
+	if(tok != nullptr)
+	{
+	    try
+	    {
+		tok_ref = add_wait(tok, cond, wake, instance);
+	    }
+	    catch(...)
+	    {
+		if(cur != nullptr)
+		    remove_wait(cur, cur_ref);
+		throw;
+	    }
+	}
+	registered = true;
+
+	    // registration must be done before checking the cancellation flag
+	    // for cancel() to either see our registration or we see its flag
+	if(cancelled())
+	{
+	    release();
+	    throw_cancel();
+	}
+    }
+
+    void cancellation_token::wait_registration::release()
+    {
+	if(registered)
+	{
+	    if(cur != nullptr)
+		remove_wait(cur, cur_ref);
+	    if(tok != nullptr)
+		remove_wait(tok, tok_ref);
+	    registered = false;
+	}
+    }
+
+    bool cancellation_token::wait_registration::cancelled() const
+    {
+	return (cur != nullptr && cur->cancelled.load(memory_order_relaxed))
+	    || (tok != nullptr && tok->cancelled.load(memory_order_relaxed));
+    }
+
+    bool cancellation_token::has_registered_waits() const
+    {
+	bool ret;
+
+	if(! st)
+	    return false;
+
+	st->control.lock();
+	ret = ! st->waits.empty();
+	st->control.unlock();
+
+	return ret;
+    }
+
+    void cancellation_token::cancel_state(shared_ptr<state> target)
+    {
+	bool done = false;
+	vector<shared_ptr<state> > to_cancel;
+
+	if(target->cancelled.exchange(true))
+	    return; // already cancelled
+
+	do
+	{
+	    done = true;
+
+	    target->control.lock();
+	    try
+	    {
+		for(list<registration>::iterator it = target->waits.begin(); it != target->waits.end(); ++it)
+		{
+		    if(it->woken)
+			continue;
+
+			// the condition cannot be destroyed while we hold control
+			// as the waiting thread cannot unregister and leave condition::wait(),
+			// but it needs the condition's lock to unregister so we must not
+			// block on that lock while holding control. The wake function hands
+			// the wake-up over to the lock holder and only fails for the
+			// few instructions the lock is being taken or released
+		    if(it->wake(it->cond, it->instance))
+			it->woken = true;
+		    else
+			done = false;
+		}
+
+		if(done)
+		{
+		    for(list<weak_ptr<state> >::iterator it = target->children.begin(); it != target->children.end(); ++it)
+		    {
+			shared_ptr<state> child = it->lock();
+			if(child)
+			    to_cancel.push_back(child);
+		    }
+		    target->children.clear();
+		}
+	    }
+	    catch(...)
+	    {
+		target->control.unlock();
+		throw;
+	    }
+	    target->control.unlock();
+
+	    if(!done)
+		sched_yield();
+	}
+	while(!done);
+
+	for(vector<shared_ptr<state> >::iterator it = to_cancel.begin(); it != to_cancel.end(); ++it)
+	    cancel_state(*it);
+    }
+
+    void cancellation_token::throw_cancel()
+    {
+	throw thread::cancel_except();
+    }
+
+    list<cancellation_token::registration>::iterator cancellation_token::add_wait(state *target, void *cond, wake_function wake, unsigned int instance)
+    {
+	list<registration>::iterator ret;
+	registration reg;
+
+	if(cond == nullptr || wake == nullptr)
+	    throw THREADAR_BUG;
+
+	reg.cond = cond;
+	reg.wake = wake;
+	reg.instance = instance;
+	reg.woken = false;
+
+	target->control.lock();
+	try
+	{
+	    ret = target->waits.insert(target->waits.end(), reg);
+	}
+	catch(...)
+	{
+	    target->control.unlock();
+	    throw;
+	}
+	target->control.unlock();
+
+	return ret;
+    }
+
+    void cancellation_token::remove_wait(state *target, list<registration>::iterator ref)
+    {
+	target->control.lock();
+	target->waits.erase(ref);
+	target->control.unlock();
+    }
+
+} // end of namespace
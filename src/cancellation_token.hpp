@@ -0,0 +1,208 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef LIBTHREADAR_CANCELLATION_TOKEN_HPP
+#define LIBTHREADAR_CANCELLATION_TOKEN_HPP
+
+    /// \file cancellation_token.hpp
+    /// \brief defines the cancellation_token class used to request and check cancellation without lock
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+#include <list>
+#include <memory>
+
+    // libthreadar headers
+#include "mutex.hpp"
+
+namespace libthreadar
+{
+
+    class condition;
+    class futex_condition;
+
+	/// Class cancellation_token carries a cancellation request between threads
+
+	/// Copies of a cancellation_token share the same state: calling cancel() on one of them
+	/// is seen by all copies. Checking whether cancellation has been requested is a single
+	/// relaxed atomic load, cheap enough to be done at each iteration of an inner loop.
+	///
+	/// Each libthreadar::thread owns a token (see thread::get_cancellation_token()) that is
+	/// cancelled by thread::cancel(), and that is the \e current token of the thread running
+	/// inherited_run(). The current token can be checked from any function with current_cancelled()
+	/// or current_checkpoint() without any reference to the thread object. Tasks submitted to a
+	/// thread_pool inherit the current token of the submitting thread.
+	///
+	/// A child token (see make_child()) is cancelled when its parent is, but cancelling the
+	/// child does not affect its parent.
+	///
+	/// Threads suspended on a libthreadar::condition (and the classes relying on it) with a token
+	/// or with the current token of their thread are awaken by cancel() and get a
+	/// thread::cancel_except exception.
+
+    class cancellation_token
+    {
+    private:
+	struct state;
+
+    public:
+	    /// constructor, the new token is not cancelled and has no parent
+	cancellation_token();
+
+	    /// copy constructor, the copy shares the same state
+	cancellation_token(const cancellation_token & ref) = default;
+
+	    /// assignment operator, the object shares the state of ref
+	cancellation_token & operator = (const cancellation_token & ref) = default;
+
+	    /// destructor
+	~cancellation_token() = default;
+
+	    /// request cancellation
+
+	    /// \note all threads waiting on a condition with this token or a child of it are awaken
+	    /// \note cancel() can be called while holding the lock of such a condition, the threads
+	    /// are then awaken when the lock is released
+	void cancel();
+
+	    /// whether cancellation has been requested (lock-free)
+	bool is_cancelled() const { return st->cancelled.load(std::memory_order_relaxed); };
+
+	    /// throw thread::cancel_except if cancellation has been requested
+	void checkpoint() const { if(is_cancelled()) throw_cancel(); };
+
+	    /// create a new token that gets cancelled when this one is
+	cancellation_token make_child() const;
+
+	    /// whether the calling thread has a current token
+	static bool has_current() { return current_state != nullptr; };
+
+	    /// the current token of the calling thread
+
+	    /// \note if the calling thread has no current token a new token is returned
+	static cancellation_token current();
+
+	    /// whether the current token of the calling thread is cancelled (lock-free)
+	static bool current_cancelled()
+	{
+	    state *cur = current_state;
+	    return cur != nullptr && cur->cancelled.load(std::memory_order_relaxed);
+	};
+
+	    /// throw thread::cancel_except if the current token of the calling thread is cancelled
+	static void current_checkpoint() { if(current_cancelled()) throw_cancel(); };
+
+	    /// makes a token the current token of the calling thread for the life of the scope object
+	class scope
+	{
+	public:
+	    scope(const cancellation_token & token);
+	    scope(const scope & ref) = delete;
+	    scope & operator = (const scope & ref) = delete;
+	    ~scope();
+
+	private:
+	    state *previous;
+	};
+
+    private:
+	    /// awakes the threads waiting on an instance of a condition object
+
+	    /// \note must not block: returns false only if the wake-up has to be retried shortly,
+	    /// when the condition lock is about to be released
+	typedef bool (*wake_function)(void *cond, unsigned int instance);
+
+	struct registration
+	{
+	    void *cond;            ///< condition (or futex_condition) a thread is suspended on
+	    wake_function wake;    ///< how to awake threads suspended on cond
+	    unsigned int instance; ///< condition instance the thread is suspended on
+	    bool woken;            ///< set by cancel() once the instance has been broadcast
+	};
+
+	struct state : public std::enable_shared_from_this<state>
+	{
+	    std::atomic<bool> cancelled;
+	    mutex control;                            ///< protects the fields below
+	    std::list<registration> waits;            ///< threads suspended with this token
+	    std::list<std::weak_ptr<state> > children; ///< child tokens
+
+	    state(): cancelled(false) {};
+	};
+
+	    /// registration of a wait on both the current token and an explicit token
+
+	    /// \note the constructor throws thread::cancel_except if one of the tokens is already cancelled
+	class wait_registration
+	{
+	public:
+	    wait_registration(void *cond, wake_function wake, unsigned int instance, const cancellation_token *token);
+	    wait_registration(const wait_registration & ref) = delete;
+	    wait_registration & operator = (const wait_registration & ref) = delete;
+	    ~wait_registration() { release(); };
+
+		/// remove the registration (done by the destructor if not called before)
+	    void release();
+
+		/// whether one of the tokens has been cancelled
+	    bool cancelled() const;
+
+	private:
+	    state *cur;
+	    state *tok;
+	    std::list<registration>::iterator cur_ref;
+	    std::list<registration>::iterator tok_ref;
+	    bool registered;
+	};
+
+	std::shared_ptr<state> st;
+
+	    /// token without state, only used internally by thread_pool for tasks without current token
+	cancellation_token(std::nullptr_t) {};
+
+	bool has_registered_waits() const;
+
+	static thread_local state *current_state;
+
+	static void cancel_state(std::shared_ptr<state> target);
+	static void throw_cancel();
+	static std::list<registration>::iterator add_wait(state *target, void *cond, wake_function wake, unsigned int instance);
+	static void remove_wait(state *target, std::list<registration>::iterator ref);
+
+	friend class condition;
+	friend class futex_condition;
+	friend class futex_semaphore;
+	friend class latch;
+	friend class thread;
+	friend class thread_pool;
+    };
+
+} // end of namespace
+
+#endif
@@ -26,9 +26,17 @@
     // C system headers
 extern "C"
 {
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#if HAVE_TIME_H
+#include <time.h>
+#endif
 }
     // C++ standard headers
 #include <string>
+#include <chrono>
+#include <new>
 
     // libthreadar headers
 
@@ -40,56 +48,106 @@ using namespace std;
 namespace libthreadar
 {
 
-    condition::condition(unsigned int num): cond(num), counter(num)
+    condition::condition(unsigned int num): num_instances(num), lock_state(state_free)
     {
+	pthread_condattr_t attr;
+
 	if(num < 1)
 	    throw exception_range("need at least one instance to create a condition object");
 
+	cond.reset(new (nothrow) pthread_cond_t[num]);
+	counter.reset(new (nothrow) waiter_count[num]);
+	if(! cond || ! counter)
+	    throw exception_memory();
+
+	if(pthread_condattr_init(&attr) != 0)
+	    throw string("Error while creating condition attributes");
+
+#if HAVE_PTHREAD_CONDATTR_SETCLOCK
+	    // timed waits are measured on the clock of std::chrono::steady_clock
+	if(pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) != 0)
+	{
+	    (void)pthread_condattr_destroy(&attr);
+	    throw string("Error while setting condition clock");
+	}
+#endif
+
 	for(unsigned int i = 0; i < num; ++i)
 	{
-	    int ret = pthread_cond_init(&(cond[i]), NULL);
+	    int ret = pthread_cond_init(&(cond[i]), &attr);
 	    if(ret != 0)
 	    {
 		for(signed int dec = i - 1; dec >= 0; --dec)
 		    (void)pthread_cond_destroy(&(cond[dec]));
+		(void)pthread_condattr_destroy(&attr);
 		throw string("Error while creating condition");
 	    }
-	    counter[i] = 0;
 	}
+
+	(void)pthread_condattr_destroy(&attr);
     }
 
     condition::~condition()
     {
-	std::deque<pthread_cond_t>::iterator it = cond.begin();
+	for(unsigned int i = 0; i < num_instances; ++i)
+	    (void)pthread_cond_destroy(&(cond[i]));
+    }
 
-	while(it != cond.end())
+    void condition::unlock()
+    {
+	try
 	{
-	    (void)pthread_cond_destroy(&(*it));
-	    ++it;
+	    release_state();
 	}
+	catch(...)
+	{
+	    mutex::unlock();
+	    throw;
+	}
+	mutex::unlock();
+    }
+
+    bool condition::try_lock()
+    {
+	bool ret = mutex::try_lock();
+
+	if(ret)
+	    lock_state.store(state_held, memory_order_relaxed);
+
+	return ret;
     }
 
     void condition::wait(unsigned int instance)
     {
-	if(instance < cond.size())
-	{
-	    ++counter[instance];
-	    int ret = pthread_cond_wait(&(cond[instance]), &mut);
-	    --counter[instance];
-	    if(ret != 0)
-		throw string("Error while going to wait on condition");
-	}
-	else
-	    throw exception_range("the instance number given to condition::wait() is out of range");
+	(void)wait_with(instance, nullptr, nullptr);
+    }
+
+    void condition::wait(unsigned int instance, const cancellation_token & token)
+    {
+	(void)wait_with(instance, &token, nullptr);
+    }
+
+    bool condition::wait_until(unsigned int instance, chrono::steady_clock::time_point deadline)
+    {
+	return wait_with(instance, nullptr, &deadline);
+    }
+
+    bool condition::wait_until(unsigned int instance, chrono::steady_clock::time_point deadline, const cancellation_token & token)
+    {
+	return wait_with(instance, &token, &deadline);
     }
 
     void condition::signal(unsigned int instance)
     {
-	if(instance < cond.size())
+	if(instance < num_instances)
 	{
-	    int ret = pthread_cond_signal(&(cond[instance]));
-	    if(ret != 0)
-		throw string("Error while unlocking and signaling");
+		// no thread waiting, no need to enter the kernel
+	    if(counter[instance].num.load(memory_order_relaxed) > 0)
+	    {
+		int ret = pthread_cond_signal(&(cond[instance]));
+		if(ret != 0)
+		    throw string("Error while unlocking and signaling");
+	    }
 	}
 	else
 	    throw exception_range("the instance number given to condition::signal() is out of range");
@@ -97,15 +155,168 @@ namespace libthreadar
 
     void condition::broadcast(unsigned int instance)
     {
-	if(instance < cond.size())
+	if(instance < num_instances)
 	{
-	    int ret = pthread_cond_broadcast(&(cond[instance]));
-	    if(ret != 0)
-		throw string("Error while unlocking and broadcasting");
+	    if(counter[instance].num.load(memory_order_relaxed) > 0)
+	    {
+		int ret = pthread_cond_broadcast(&(cond[instance]));
+		if(ret != 0)
+		    throw string("Error while unlocking and broadcasting");
+	    }
 	}
 	else
 	    throw exception_range("the instance number given to condition::broadcast() is out of range");
     }
 
+    bool condition::wait_with(unsigned int instance, const cancellation_token *token, const chrono::steady_clock::time_point *deadline)
+    {
+	if(instance < num_instances)
+	{
+	    cancellation_token::wait_registration reg(this, &cancel_wake, instance, token);
+	    bool profiled = lock_profiler::sampling.load(memory_order_relaxed) != 0;
+	    bool sampled = profiled && lock_profiler::take_sample();
+	    chrono::steady_clock::time_point start;
+	    struct timespec abstime;
+	    int ret;
+
+	    if(sampled)
+		start = chrono::steady_clock::now();
+
+	    if(deadline != nullptr)
+		deadline_to_timespec(*deadline, abstime);
+
+	    counter[instance].num.fetch_add(1, memory_order_relaxed);
+
+		// pthread_cond_wait() releases the lock, a cancellation seeing
+		// the lock held before we release it has asked us to broadcast
+	    try
+	    {
+		release_state();
+	    }
+	    catch(...)
+	    {
+		counter[instance].num.fetch_sub(1, memory_order_relaxed);
+		lock_state.store(state_held, memory_order_relaxed);
+		throw;
+	    }
+
+	    if(reg.cancelled())
+		ret = 0;
+	    else if(deadline != nullptr)
+		ret = pthread_cond_timedwait(&(cond[instance]), &mut, &abstime);
+	    else
+		ret = pthread_cond_wait(&(cond[instance]), &mut);
+	    lock_state.store(state_held, memory_order_relaxed);
+	    counter[instance].num.fetch_sub(1, memory_order_relaxed);
+	    reg.release();
+
+	    if(ret != 0 && ret != ETIMEDOUT)
+		throw string("Error while going to wait on condition");
+
+	    if(profiled)
+		lock_profiler::waited(prof,
+				      this,
+				      sampled,
+				      sampled ? chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start) : chrono::nanoseconds(0));
+
+	    if(reg.cancelled())
+	    {
+		    // we may have consumed a signal() aimed at another thread
+		signal(instance);
+		cancellation_token::throw_cancel();
+	    }
+
+	    return ret != ETIMEDOUT;
+	}
+	else
+	    throw exception_range("the instance number given to condition::wait() is out of range");
+    }
+
+    unsigned int condition::get_waiting_thread_count(unsigned int instance) const
+    {
+	if(instance >= num_instances)
+	    throw exception_range("the instance number given to condition::get_waiting_thread_count() is out of range");
+
+	return counter[instance].num.load(memory_order_relaxed);
+    }
+
+    bool condition::cancel_wake(void *obj, unsigned int instance)
+    {
+	condition *me = static_cast<condition *>(obj);
+
+	if(me == nullptr)
+	    throw THREADAR_BUG;
+
+	unsigned int cur = me->lock_state.load();
+
+	    // the cancellation flag has been set before, either the thread holding
+	    // the lock sees our request when releasing it and broadcasts, or we
+	    // get the lock and broadcast ourselves
+
+	while(cur != state_free)
+	{
+	    if(me->lock_state.compare_exchange_weak(cur, cur | wake_pending))
+		return true;
+	}
+
+	    // the lock may still be held by a thread that has just acquired it
+	    // or by a waiting thread about to release it in pthread_cond_wait(),
+	    // both only last a few instructions and cancellation_token retries
+	if(! me->try_lock())
+	    return false;
+
+	try
+	{
+	    me->broadcast(instance);
+	}
+	catch(...)
+	{
+	    me->unlock();
+	    throw;
+	}
+	me->unlock();
+
+	return true;
+    }
+
+    void condition::release_state()
+    {
+	    // must be called with the lock held, just before releasing it
+
+	if((lock_state.exchange(state_free, memory_order_acq_rel) & wake_pending) != 0)
+	    broadcast_all();
+    }
+
+    void condition::broadcast_all()
+    {
+	    // we do not know which instance the cancelled thread waits on,
+	    // the others get a spurious wake-up
+	for(unsigned int i = 0; i < num_instances; ++i)
+	    broadcast(i);
+    }
+
+    void condition::deadline_to_timespec(chrono::steady_clock::time_point deadline, struct timespec & abstime)
+    {
+#if HAVE_PTHREAD_CONDATTR_SETCLOCK
+	    // steady_clock relies on CLOCK_MONOTONIC, the clock of the pthread_cond_t
+	chrono::nanoseconds since = chrono::duration_cast<chrono::nanoseconds>(deadline.time_since_epoch());
+#else
+	    // pthread_cond_t uses CLOCK_REALTIME, converting the remaining time
+	chrono::nanoseconds since = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch())
+	    + chrono::duration_cast<chrono::nanoseconds>(deadline - chrono::steady_clock::now());
+#endif
+	chrono::seconds sec = chrono::duration_cast<chrono::seconds>(since);
+
+	if(since.count() < 0)
+	{
+	    abstime.tv_sec = 0;
+	    abstime.tv_nsec = 0;
+	}
+	else
+	{
+	    abstime.tv_sec = sec.count();
+	    abstime.tv_nsec = (since - sec).count();
+	}
+    }
 
 } // end of namespace
@@ -29,8 +29,11 @@
 
 #include "mutex.hpp"
 #include "exceptions.hpp"
+#include "cancellation_token.hpp"
 
-#include <deque>
+#include <atomic>
+#include <memory>
+#include <chrono>
 
 namespace libthreadar
 {
@@ -60,17 +63,31 @@ namespace libthreadar
 	condition(const condition & ref) = delete;
 
 	    /// no move constructor
-	condition(condition && ref) = default;
+	condition(condition && ref) = delete;
 
 	    /// no assignment operator
 	condition & operator = (const condition & ref) = delete;
 
 	    /// no move operator
-	condition & operator = (condition && ref) noexcept = default;
+	condition & operator = (condition && ref) = delete;
 
 	    /// destructor
 	~condition();
 
+	    /// lock the object
+
+	    /// \note this hides mutex::lock(), a condition must be locked and unlocked through its own
+	    /// methods for a cancellation to be able to awake waiting threads without blocking
+	void lock() { mutex::lock(); lock_state.store(state_held, std::memory_order_relaxed); };
+
+	    /// unlock the object
+	void unlock();
+
+	    /// lock the object if no other thread holds it
+
+	    /// \return true if lock is acquired false if the object was already locked
+	bool try_lock();
+
 
 	    /// put the calling thread on hold waiting for another thread to call signal()
 
@@ -80,8 +97,77 @@ namespace libthreadar
 	    /// to use it. The mutex is re-acquires (transparently locked) once the thread exits the wait() call it was
 	    /// suspended on, which occurs if another thread calls \ref signal() with the same instance
 	    /// number
+	    /// \note as for pthread_cond_wait() the caller may be awaken without signal() having been
+	    /// called, in particular when another thread waiting on the same instance is cancelled,
+	    /// the condition the caller waits for should thus be checked again when wait() returns.
+	    /// \note when the calling thread has a current cancellation token (which is the case of
+	    /// libthreadar::thread), wait() is a cancellation point: thread::cancel() or
+	    /// cancellation_token::cancel() awakes the thread which then gets the thread::cancel_except
+	    /// exception from wait(), the object being still locked as for any other exception.
 	void wait(unsigned int instance = 0);
 
+	    /// same as wait() but also awaken when the given token is cancelled
+
+	    /// \param[in] instance the instance number to have the caller waiting on
+	    /// \param[in] token the caller is awaken and thread::cancel_except is thrown when this token
+	    /// (or the current token of the calling thread) is cancelled. The object is still locked when
+	    /// the exception is thrown.
+	void wait(unsigned int instance, const cancellation_token & token);
+
+	    /// wait until the given predicate becomes true
+
+	    /// \param[in] instance the instance number to have the caller waiting on
+	    /// \param[in] pred callable object without argument returning a bool, evaluated with the lock held
+	    /// \note this is equivalent to while(!pred()) wait(instance); and thus handles spurious wake-ups
+	template <class P> void wait(unsigned int instance, P pred) { while(! pred()) wait(instance); };
+
+	    /// same as wait(instance, pred) also awaken when the given token is cancelled
+	template <class P> void wait(unsigned int instance, P pred, const cancellation_token & token) { while(! pred()) wait(instance, token); };
+
+	    /// wait until the given predicate becomes true or the deadline is reached
+
+	    /// \return the value of the predicate when the call returns
+	template <class P> bool wait_until(unsigned int instance, std::chrono::steady_clock::time_point deadline, P pred)
+	{
+	    while(! pred())
+		if(! wait_until(instance, deadline))
+		    return pred();
+	    return true;
+	};
+
+	    /// wait until the given predicate becomes true or the duration expired
+
+	    /// \return the value of the predicate when the call returns
+	template <class P> bool wait_for(unsigned int instance, std::chrono::nanoseconds duration, P pred)
+	{ return wait_until(instance, std::chrono::steady_clock::now() + duration, pred); };
+
+	    /// same as wait() but limiting the time the caller is suspended
+
+	    /// \param[in] instance the instance number to have the caller waiting on
+	    /// \param[in] deadline the time at which the caller is awaken if it has not been before
+	    /// \return false if the deadline has been reached, true if awaken before (which as for wait()
+	    /// may occur without signal() having been called)
+	    /// \note the deadline is measured on std::chrono::steady_clock, which under Linux is
+	    /// CLOCK_MONOTONIC: changing the system time does not shorten nor extend the wait.
+	    /// \note as wait(), wait_until() is a cancellation point
+	bool wait_until(unsigned int instance, std::chrono::steady_clock::time_point deadline);
+
+	    /// same as wait_until() also awaken when the given token is cancelled
+	bool wait_until(unsigned int instance, std::chrono::steady_clock::time_point deadline, const cancellation_token & token);
+
+	    /// same as wait() but limiting the time the caller is suspended
+
+	    /// \param[in] instance the instance number to have the caller waiting on
+	    /// \param[in] duration maximum time to wait
+	    /// \return false if the duration expired, true if awaken before
+	    /// \note see wait_until() for details
+	bool wait_for(unsigned int instance, std::chrono::nanoseconds duration)
+	{ return wait_until(instance, std::chrono::steady_clock::now() + duration); };
+
+	    /// same as wait_for() also awaken when the given token is cancelled
+	bool wait_for(unsigned int instance, std::chrono::nanoseconds duration, const cancellation_token & token)
+	{ return wait_until(instance, std::chrono::steady_clock::now() + duration, token); };
+
 	    /// awakes a single thread suspended for having called wait() on the condition given in argument
 
 	    /// \param[in] instance the condition number to consider, only thread having called
@@ -89,6 +175,8 @@ namespace libthreadar
 	    /// \note signal() must be called between lock() and unlock(). This is only at
 	    /// the time unlock() is called that another thread exits from the suspended
 	    /// state.
+	    /// \note signal() does nothing (no system call) when no thread waits on that instance,
+	    /// there is thus no need to check get_waiting_thread_count() before calling it
 	void signal(unsigned int instance = 0);
 
 	    /// awakes all threads suspended for having called wait() on the condition given in argument
@@ -102,11 +190,38 @@ namespace libthreadar
 	    /// return the number of thread currently waiting on that condition
 
 	    /// \param[in] instance the condition instance number to count the waiting thread on
-	unsigned int get_waiting_thread_count(unsigned int instance = 0) const { return counter[instance]; };
+	    /// \note the counters are atomic, this method can be called without holding the lock,
+	    /// the returned value is then only a hint as threads may start or stop waiting meanwhile
+	unsigned int get_waiting_thread_count(unsigned int instance = 0) const;
 
     private:
-	std::deque<pthread_cond_t> cond;
-	std::deque<unsigned int> counter;
+
+	    /// waiting thread counter of an instance, on its own cache line
+	struct waiter_count
+	{
+	    std::atomic<unsigned int> num;
+	    char pad[64 - sizeof(std::atomic<unsigned int>)];
+
+	    waiter_count(): num(0) {};
+	};
+
+	unsigned int num_instances;                 ///< number of instances
+	std::unique_ptr<pthread_cond_t[]> cond;     ///< one pthread condition per instance
+	std::unique_ptr<waiter_count[]> counter;    ///< number of threads waiting per instance
+
+	static const unsigned int state_free = 0;   ///< lock not held, or about to be released
+	static const unsigned int state_held = 1;   ///< lock held
+	static const unsigned int wake_pending = 2; ///< a cancellation asks the holder to broadcast when releasing the lock
+
+	std::atomic<unsigned int> lock_state;       ///< combination of the above values
+
+	bool wait_with(unsigned int instance, const cancellation_token *token, const std::chrono::steady_clock::time_point *deadline);
+
+	void release_state();
+	void broadcast_all();
+
+	static bool cancel_wake(void *obj, unsigned int instance);
+	static void deadline_to_timespec(std::chrono::steady_clock::time_point deadline, struct timespec & abstime);
 
     };
 
@@ -0,0 +1,175 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+}
+    // C++ standard headers
+#include <fstream>
+#include <sstream>
+
+    // libthreadar headers
+#include "tools.hpp"
+
+    // this module's header
+#include "cpu_topology.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+    static const char *sys_cpu = "/sys/devices/system/cpu/";
+    static const char *sys_node = "/sys/devices/system/node/";
+
+    set<unsigned int> cpu_topology::online_cpus()
+    {
+	return parse_cpu_list(read_sysfs(string(sys_cpu) + "online"));
+    }
+
+    set<unsigned int> cpu_topology::numa_nodes()
+    {
+	string path = string(sys_node) + "online";
+
+	if(! sysfs_exists(path))
+	{
+	    set<unsigned int> ret;
+
+	    ret.insert(0); // kernel without NUMA support
+	    return ret;
+	}
+	else
+	    return parse_cpu_list(read_sysfs(path));
+    }
+
+    set<unsigned int> cpu_topology::node_cpus(unsigned int node)
+    {
+	string path = string(sys_node) + "node" + tools_convert_to_string(node) + "/cpulist";
+
+	if(! sysfs_exists(path))
+	{
+	    if(node == 0 && ! sysfs_exists(sys_node))
+		return online_cpus(); // kernel without NUMA support
+	    else
+		throw exception_range(string("unknown NUMA node ") + tools_convert_to_string(node));
+	}
+
+	return parse_cpu_list(read_sysfs(path));
+    }
+
+    unsigned int cpu_topology::cpu_node(unsigned int cpu)
+    {
+	set<unsigned int> nodes = numa_nodes();
+
+	for(set<unsigned int>::iterator it = nodes.begin(); it != nodes.end(); ++it)
+	{
+	    set<unsigned int> cpus = node_cpus(*it);
+	    if(cpus.find(cpu) != cpus.end())
+		return *it;
+	}
+
+	throw exception_range(string("unknown CPU ") + tools_convert_to_string(cpu));
+    }
+
+    set<unsigned int> cpu_topology::cache_sharing_cpus(unsigned int cpu, unsigned int level)
+    {
+	string base = string(sys_cpu) + "cpu" + tools_convert_to_string(cpu) + "/cache/index";
+
+	for(unsigned int index = 0; sysfs_exists(base + tools_convert_to_string(index)); ++index)
+	{
+	    string dir = base + tools_convert_to_string(index) + "/";
+	    unsigned int cache_level;
+	    string type;
+
+	    if(! (istringstream(read_sysfs(dir + "level")) >> cache_level))
+		throw exception_range(string("unexpected content in ") + dir + "level");
+	    type = read_sysfs(dir + "type");
+
+	    if(cache_level == level && type != "Instruction")
+		return parse_cpu_list(read_sysfs(dir + "shared_cpu_list"));
+	}
+
+	throw exception_range(string("no cache of level ") + tools_convert_to_string(level) + " found for CPU " + tools_convert_to_string(cpu));
+    }
+
+    set<unsigned int> cpu_topology::parse_cpu_list(const string & list)
+    {
+	set<unsigned int> ret;
+	istringstream in(list);
+	string range;
+
+	while(getline(in, range, ','))
+	{
+	    unsigned int first, last;
+	    char sep;
+	    istringstream rg(range);
+
+	    if(range.empty() || range == "\n")
+		continue;
+
+	    if(! (rg >> first))
+		throw exception_range(string("malformed CPU list: ") + list);
+	    if(rg >> sep)
+	    {
+		if(sep != '-' || ! (rg >> last) || last < first)
+		    throw exception_range(string("malformed CPU list: ") + list);
+	    }
+	    else
+		last = first;
+
+	    for(unsigned int cpu = first; cpu <= last; ++cpu)
+		ret.insert(cpu);
+	}
+
+	return ret;
+    }
+
+    string cpu_topology::read_sysfs(const string & path)
+    {
+	ifstream in(path.c_str());
+	string ret;
+
+	if(! in)
+	    throw exception_system(string("Failed opening ") + path + ": ", errno);
+
+	getline(in, ret);
+
+	return ret;
+    }
+
+    bool cpu_topology::sysfs_exists(const string & path)
+    {
+	ifstream in(path.c_str());
+
+	    // opening a directory with ifstream succeeds on Linux
+	    // which is fine for our use
+	return bool(in);
+    }
+
+} // end of namespace
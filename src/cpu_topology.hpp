@@ -0,0 +1,91 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef LIBTHREADAR_CPU_TOPOLOGY_HPP
+#define LIBTHREADAR_CPU_TOPOLOGY_HPP
+
+    /// \file cpu_topology.hpp
+    /// \brief defines the cpu_topology class that reports the CPUs and NUMA nodes of the system
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <set>
+#include <string>
+
+    // libthreadar headers
+#include "exceptions.hpp"
+
+namespace libthreadar
+{
+
+	/// Class cpu_topology provides information about the CPUs of the system
+
+	/// This information is read from /sys/devices/system/cpu and /sys/devices/system/node
+	/// (Linux sysfs). It can be used to choose the CPU set given to thread::set_cpu_affinity(),
+	/// for example to place two threads exchanging data through a fast_tampon on CPUs
+	/// sharing the same L3 cache. On systems without sysfs an exception_system is thrown.
+	///
+	/// All methods are static, CPU sets are given as sets of CPU numbers.
+
+    class cpu_topology
+    {
+    public:
+	cpu_topology() = delete;
+
+	    /// the CPUs currently online
+	static std::set<unsigned int> online_cpus();
+
+	    /// the NUMA nodes currently online
+
+	    /// \note a system without NUMA support reports a single node zero
+	static std::set<unsigned int> numa_nodes();
+
+	    /// the CPUs of the given NUMA node
+	static std::set<unsigned int> node_cpus(unsigned int node);
+
+	    /// the NUMA node a given CPU belongs to
+	static unsigned int cpu_node(unsigned int cpu);
+
+	    /// the CPUs sharing with the given CPU the cache of the given level
+
+	    /// \param[in] cpu the CPU to consider
+	    /// \param[in] level the cache level (3 for L3 cache)
+	    /// \return the CPUs sharing that cache, including the given CPU
+	static std::set<unsigned int> cache_sharing_cpus(unsigned int cpu, unsigned int level = 3);
+
+	    /// convert a sysfs CPU list ("0-3,8,10-11") to a set of CPU numbers
+	static std::set<unsigned int> parse_cpu_list(const std::string & list);
+
+    private:
+	static std::string read_sysfs(const std::string & path);
+	static bool sysfs_exists(const std::string & path);
+    };
+
+} // end of namespace
+
+#endif
@@ -35,10 +35,11 @@ extern "C"
 
 }
     // C++ standard headers
-
+#include <atomic>
 
     // libthreadar headers
 #include "condition.hpp"
+#include "lock_guard.hpp"
 #include "exceptions.hpp"
 
 namespace libthreadar
@@ -76,15 +77,21 @@ namespace libthreadar
 	///
 	/// Only on thread can be a feeder, only one (other) thread can be a fetcher.
 	///
+	/// The feeding and fetching positions are atomics, feed() and fetch_recycle() only take
+	/// the lock to awake the other thread when it is suspended.
+	///
 	/// fast_tampon objects cannot be copied, once created they can only be passed as reference
 	/// or using a pointer to them.
 	///
-	/// \note Class fast_tampon is a template with a single type 'T' as argument. This type is the
+	/// \note Class fast_tampon is a template with a type 'T' as first argument. This type is the
 	/// base type of the memory block. If you want to exchanges blocks of char between two
 	/// threads by use of char * pointers, use tampon<char>
+	/// \note the second template argument is the type of the internal lock and conditions,
+	/// libthreadar::condition by default, futex_condition can be used instead to avoid the
+	/// pthread layer.
 
 
-    template <class T> class fast_tampon
+    template <class T, class C = condition> class fast_tampon
     {
     public:
 	    /// constructor
@@ -118,6 +125,9 @@ namespace libthreadar
 	    /// \note note that the caller shall never release the address pointed to by ptr
 	void get_block_to_feed(T * & ptr, unsigned int & num);
 
+	    /// same as get_block_to_feed() but aborts with thread::cancel_except if the token is cancelled while waiting for a free block
+	void get_block_to_feed(T * & ptr, unsigned int & num, const cancellation_token & token);
+
 	    /// feeder call - step 2
 
 	    /// Once data has been copied into the block obtained by a call to get_block_to_feed(), use this call to given back this block to the fast_tampon object
@@ -140,6 +150,9 @@ namespace libthreadar
 	    /// \note that the caller shall never release the address pointed to by ptr
 	void fetch(T* & ptr, unsigned int & num);
 
+	    /// same as fetch() but aborts with thread::cancel_except if the token is cancelled while waiting for a block to read
+	void fetch(T* & ptr, unsigned int & num, const cancellation_token & token);
+
 	    /// fetcher call - step 2
 
 	    /// Once data has been read, the fetcher must recycle the block into the fast_tampon object
@@ -159,13 +172,13 @@ namespace libthreadar
 	void fetch_push_back(T *ptr, unsigned int new_num);
 
 	    /// to know whether the fast_tampon has objects (readable or skipped)
-	bool is_empty() const { return next_feed == next_fetch; };
+	bool is_empty() const { return next_feed.load() == next_fetch.load(); };
 
 	    /// to know whether the fast_tampon is *not* empty
 	bool is_not_empty() const { return !is_empty(); };
 
 	    /// for feeder to know whether the next call to get_block_to_feed() will be blocking
-	bool is_full() const { unsigned int tmp = next_feed; shift_by_one(tmp); return tmp == next_fetch; };
+	bool is_full() const { unsigned int tmp = next_feed.load(); shift_by_one(tmp); return tmp == next_fetch.load(); };
 
 	    /// to know whether the fast_tampon is *not* full
 	bool is_not_full() const { return !is_full(); };
@@ -196,21 +209,29 @@ namespace libthreadar
 	static const unsigned int cond_full = 0;
 	static const unsigned int cond_empty = 0;
 
-	condition modif;
+	C modif;                  //< lock and conditions, libthreadar::condition by default
 	atom *table;              //< datastructure holding data in transit between two threads
 	unsigned int table_size;  //< size of table, i.e. number of struct atom it holds
 	unsigned int alloc_size;  //< size of allocated memory for each atom in table
-	unsigned int next_feed;   //< index in table of the next atom to use for feeding the table
-	unsigned int next_fetch;  //< index in table of the next atom to fetch from table
+	std::atomic<unsigned int> next_feed;  //< index in table of the next atom to use for feeding the table, only modified by the feeder
+	std::atomic<unsigned int> next_fetch; //< index in table of the next atom to fetch from table, only modified by the fetcher
+	std::atomic<bool> feeder_waiting;     //< set by the feeder while suspended on a full table
+	std::atomic<bool> fetcher_waiting;    //< set by the fetcher while suspended on an empty table
 	bool fetch_outside;       //< if set to true, table's index pointed to by next_fetch is used by the fetcher
 	bool feed_outside;        //< if set to true, table's index pointed to by next_feed is used by the feeder
 
+	    /// implementation of get_block_to_feed(), token being nullptr when none was given
+	void get_block_to_feed_with(T * & ptr, unsigned int & num, const cancellation_token *token);
+
+	    /// implementation of fetch(), token being nullptr when none was given
+	void fetch_with(T* & ptr, unsigned int & num, const cancellation_token *token);
+
 	    /// cyclicly shift an index (next_feed or next_fetch) by one position
 	void shift_by_one(unsigned int & x) const;
 
     };
 
-    template <class T> fast_tampon<T>::fast_tampon(unsigned int max_block, unsigned int block_size): modif(2)
+    template <class T, class C> fast_tampon<T, C>::fast_tampon(unsigned int max_block, unsigned int block_size): modif(2), next_feed(0), next_fetch(0), feeder_waiting(false), fetcher_waiting(false)
     {
 	if(max_block < 2)
 	    throw exception_range("max_block for fast_tampon should be strictly greater than 1");
@@ -252,7 +273,7 @@ namespace libthreadar
     }
 
 
-    template <class T> fast_tampon<T>::~fast_tampon()
+    template <class T, class C> fast_tampon<T, C>::~fast_tampon()
     {
 	if(table != nullptr)
 	{
@@ -265,148 +286,172 @@ namespace libthreadar
 	}
     }
 
-    template <class T> void fast_tampon<T>::get_block_to_feed(T * & ptr, unsigned int & num)
+    template <class T, class C> void fast_tampon<T, C>::get_block_to_feed(T * & ptr, unsigned int & num)
+    {
+	get_block_to_feed_with(ptr, num, nullptr);
+    }
+
+    template <class T, class C> void fast_tampon<T, C>::get_block_to_feed(T * & ptr, unsigned int & num, const cancellation_token & token)
+    {
+	get_block_to_feed_with(ptr, num, &token);
+    }
+
+    template <class T, class C> void fast_tampon<T, C>::get_block_to_feed_with(T * & ptr, unsigned int & num, const cancellation_token *token)
     {
 	if(feed_outside)
 	    throw exception_range("feed already out!");
 
 	if(is_full())
 	{
-	    modif.lock();  // --- critical section START
+	    lock_guard<C> lock(modif);  // --- critical section up to end of block
+	    auto not_full = [this]() { return ! is_full(); };
+
+		// the flag is set before the predicate is checked again,
+		// see feed() for the other side
+	    feeder_waiting.store(true);
 	    try
 	    {
-		if(is_full())
-		{
-		    modif.wait(cond_full);
-
-		    if(is_full())
-			throw THREADAR_BUG; // still full!
-		}
-		    // *else*
-		    // full condition was transitional
-		    // only the feeder (this is us) can make it happen again
-		    // so the full condition should not occur before we return
-		    // the block we are about to fetch
+		if(token != nullptr)
+		    modif.wait(cond_full, not_full, *token);
+		else
+		    modif.wait(cond_full, not_full);
 	    }
 	    catch(...)
 	    {
-		modif.unlock();
+		feeder_waiting.store(false);
 		throw;
 	    }
-	    modif.unlock(); // --- critical section END
+	    feeder_waiting.store(false);
+
+		// full condition was transitional
+		// only the feeder (this is us) can make it happen again
+		// so the full condition should not occur before we return
+		// the block we are about to fetch
 	}
 
 	feed_outside = true;
-	ptr = table[next_feed].mem;
+	ptr = table[next_feed.load(std::memory_order_relaxed)].mem;
 	num = alloc_size;
     }
 
-    template <class T> void fast_tampon<T>::feed(T *ptr, unsigned int num)
+    template <class T, class C> void fast_tampon<T, C>::feed(T *ptr, unsigned int num)
     {
+	unsigned int pos = next_feed.load(std::memory_order_relaxed);
+
 	if(!feed_outside)
 	    throw exception_range("fetch not outside!");
 	feed_outside = false;
 
-	if(ptr != table[next_feed].mem)
+	if(ptr != table[pos].mem)
 	    throw exception_range("returned ptr is not the one given earlier for feeding");
-	table[next_feed].data_size = num;
+	table[pos].data_size = num;
 
-	modif.lock();   // --- critical section START
-	try
+	    // both the store and the load are sequentially consistent as are the
+	    // fetcher's flag store and predicate check, so either we see the fetcher
+	    // waiting or it sees the new block before suspending
+	shift_by_one(pos);
+	next_feed.store(pos);
+
+	if(fetcher_waiting.load())
 	{
-	    shift_by_one(next_feed);
-	    if(modif.get_waiting_thread_count(cond_empty) > 0)
-		modif.signal(cond_empty);  // releasing the fetcher when unlock() will complete
+	    lock_guard<C> lock(modif);  // the fetcher is either suspended or about to be
+	    modif.signal(cond_empty);
 	}
-	catch(...)
-	{
-	    modif.unlock();
-	    throw;
-	}
-	modif.unlock(); // --- critical section END
     }
 
-    template <class T> void fast_tampon<T>::feed_cancel_get_block(T *ptr)
+    template <class T, class C> void fast_tampon<T, C>::feed_cancel_get_block(T *ptr)
     {
 	if(!feed_outside)
 	    throw exception_range("feed not outside!");
 	feed_outside = false;
-	if(ptr != table[next_feed].mem)
+	if(ptr != table[next_feed.load(std::memory_order_relaxed)].mem)
 	    throw exception_range("returned ptr is not the one given earlier for feeding");
     }
 
-    template <class T> void fast_tampon<T>::fetch(T* & ptr, unsigned int & num)
+    template <class T, class C> void fast_tampon<T, C>::fetch(T* & ptr, unsigned int & num)
+    {
+	fetch_with(ptr, num, nullptr);
+    }
+
+    template <class T, class C> void fast_tampon<T, C>::fetch(T* & ptr, unsigned int & num, const cancellation_token & token)
+    {
+	fetch_with(ptr, num, &token);
+    }
+
+    template <class T, class C> void fast_tampon<T, C>::fetch_with(T* & ptr, unsigned int & num, const cancellation_token *token)
     {
 	if(fetch_outside)
 	    throw exception_range("already fetched block outside");
 
 	if(is_empty())
 	{
-	    modif.lock();   // --- critical section START
+	    lock_guard<C> lock(modif);   // --- critical section up to end of block
+	    auto not_empty = [this]() { return ! is_empty(); };
+
+		// the flag is set before the predicate is checked again,
+		// see feed()
+	    fetcher_waiting.store(true);
 	    try
 	    {
-		if(is_empty())
-		{
-		    modif.wait(cond_empty);
-
-		    if(is_empty())
-			throw THREADAR_BUG;
-		}
-		    // *else*
-		    // the emptiness condition was transitional
-		    // only the fetcher (this is us) can make it happen again
-		    // so the empty condition should not occur before we return
-		    // the block we are about to fetch
+		if(token != nullptr)
+		    modif.wait(cond_empty, not_empty, *token);
+		else
+		    modif.wait(cond_empty, not_empty);
 	    }
 	    catch(...)
 	    {
-		modif.unlock();
+		fetcher_waiting.store(false);
 		throw;
 	    }
-	    modif.unlock(); // --- critical section END
+	    fetcher_waiting.store(false);
+
+		// the emptiness condition was transitional
+		// only the fetcher (this is us) can make it happen again
+		// so the empty condition should not occur before we return
+		// the block we are about to fetch
 	}
 
 	fetch_outside = true;
-	ptr = table[next_fetch].mem;
-	num = table[next_fetch].data_size;
+	ptr = table[next_fetch.load(std::memory_order_relaxed)].mem;
+	num = table[next_fetch.load(std::memory_order_relaxed)].data_size;
     }
 
-    template <class T> void fast_tampon<T>::fetch_recycle(T* ptr)
+    template <class T, class C> void fast_tampon<T, C>::fetch_recycle(T* ptr)
     {
+	unsigned int pos = next_fetch.load(std::memory_order_relaxed);
+
 	if(!fetch_outside)
 	    throw exception_range("no block outside for fetching");
 	fetch_outside = false;
-	if(ptr != table[next_fetch].mem)
+	if(ptr != table[pos].mem)
 	    throw exception_range("returned ptr is no the one given earlier for fetching");
 
-	modif.lock();   // --- critical section START
-	try
-	{
-	    shift_by_one(next_fetch);
-	    if(modif.get_waiting_thread_count(cond_full) > 0)
-		modif.signal(cond_full);  // releasing the fetcher when unlock() will complete
-	}
-	catch(...)
+	    // same as feed() the other way
+	shift_by_one(pos);
+	next_fetch.store(pos);
+
+	if(feeder_waiting.load())
 	{
-	    modif.unlock();
-	    throw;
+	    lock_guard<C> lock(modif);
+	    modif.signal(cond_full);
 	}
-	modif.unlock(); // --- critical section END
     }
 
-    template <class T> void fast_tampon<T>::fetch_push_back(T* ptr, unsigned int new_num)
+    template <class T, class C> void fast_tampon<T, C>::fetch_push_back(T* ptr, unsigned int new_num)
     {
+	unsigned int pos = next_fetch.load(std::memory_order_relaxed);
+
 	if(!fetch_outside)
 	    throw exception_range("no block outside for fetching");
 	fetch_outside = false;
 
-	if(ptr != table[next_fetch].mem)
+	if(ptr != table[pos].mem)
 	    throw exception_range("returned ptr is not the one given earlier for fetching");
-	table[next_fetch].data_size = new_num;
+	table[pos].data_size = new_num;
     }
 
 
-    template <class T> void fast_tampon<T>::reset()
+    template <class T, class C> void fast_tampon<T, C>::reset()
     {
 	modif.lock(); // --- critical section START
 	try
@@ -432,7 +477,7 @@ namespace libthreadar
 	modif.unlock(); // --- critical section END
     }
 
-    template <class T> void fast_tampon<T>::shift_by_one(unsigned int & x) const
+    template <class T, class C> void fast_tampon<T, C>::shift_by_one(unsigned int & x) const
     {
 	++x;
 	if(x >= table_size)
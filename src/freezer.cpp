@@ -46,6 +46,7 @@ namespace libthreadar
     freezer::freezer()
     {
 	value = 0;
+	released = 0;
     }
 
     freezer::~freezer()
@@ -65,7 +66,33 @@ namespace libthreadar
 	{
 	    --value;
 	    if(value < 0)
-		cond.wait();
+	    {
+		try
+		{
+		    while(released == 0)
+			cond.wait();
+		}
+		catch(...)
+		{
+			// cancelled while waiting, if more threads were awaken
+			// than remain waiting one of these wake-ups was for us
+		    if(released > cond.get_waiting_thread_count())
+		    {
+			    // giving back what we have been given
+			--released;
+			++value;
+			if(value <= 0)
+			{
+			    ++released;
+			    cond.signal();
+			}
+		    }
+		    else
+			++value;
+		    throw;
+		}
+		--released;
+	    }
 	}
 	catch(...)
 	{
@@ -82,7 +109,10 @@ namespace libthreadar
 	{
 	    ++value;
 	    if(value <= 0)
+	    {
+		++released;
 		cond.signal();
+	    }
 	}
 	catch(...)
 	{
@@ -104,6 +134,7 @@ namespace libthreadar
 		if(value < 0)
 		{
 		    ++value;
+		    ++released;
 		    cond.signal();
 		}
 		else
@@ -100,6 +100,7 @@ namespace libthreadar
 
     private:
 	int value;            //< this is the freezer value
+	unsigned int released;//< number of suspended threads awaken by unlock() that have not yet returned from lock()
 	condition cond;       //< to protect access to value
     };
 
@@ -0,0 +1,148 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#if HAVE_SCHED_H
+#include <sched.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+#if HAVE_TIME_H
+#include <time.h>
+#endif
+#if HAVE_LINUX_FUTEX_H
+#include <linux/futex.h>
+#endif
+}
+    // C++ standard headers
+#include <climits>
+
+    // libthreadar headers
+#include "exceptions.hpp"
+
+    // this module's header
+#include "futex.hpp"
+
+#if HAVE_LINUX_FUTEX_H && defined(SYS_futex) && defined(FUTEX_WAIT_PRIVATE)
+#define LIBTHREADAR_USE_FUTEX 1
+#else
+#define LIBTHREADAR_USE_FUTEX 0
+#endif
+
+using namespace std;
+
+namespace libthreadar
+{
+
+#if LIBTHREADAR_USE_FUTEX
+    static_assert(sizeof(atomic<int>) == sizeof(int), "std::atomic<int> cannot be used as futex word");
+
+    static inline int *futex_word(atomic<int> & word)
+    {
+	return reinterpret_cast<int *>(&word);
+    }
+#endif
+
+    void futex::wait(atomic<int> & word, int expected)
+    {
+#if LIBTHREADAR_USE_FUTEX
+	if(syscall(SYS_futex, futex_word(word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0) != 0)
+	{
+	    switch(errno)
+	    {
+	    case EAGAIN: // word had not the expected value
+	    case EINTR:  // interrupted by a signal
+		break;
+	    default:
+		throw exception_system("Failed waiting on futex: ", errno);
+	    }
+	}
+#else
+	if(word.load(memory_order_relaxed) == expected)
+	    sched_yield();
+#endif
+    }
+
+    bool futex::wait_for(atomic<int> & word, int expected, chrono::nanoseconds timeout)
+    {
+	if(timeout.count() <= 0)
+	    return word.load(memory_order_relaxed) != expected;
+
+#if LIBTHREADAR_USE_FUTEX
+	struct timespec ts;
+	chrono::seconds sec = chrono::duration_cast<chrono::seconds>(timeout);
+
+	ts.tv_sec = sec.count();
+	ts.tv_nsec = (timeout - sec).count();
+
+	if(syscall(SYS_futex, futex_word(word), FUTEX_WAIT_PRIVATE, expected, &ts, nullptr, 0) != 0)
+	{
+	    switch(errno)
+	    {
+	    case ETIMEDOUT:
+		return false;
+	    case EAGAIN:
+	    case EINTR:
+		break;
+	    default:
+		throw exception_system("Failed waiting on futex: ", errno);
+	    }
+	}
+#else
+	if(word.load(memory_order_relaxed) == expected)
+	    sched_yield();
+#endif
+	return true;
+    }
+
+    void futex::wake(atomic<int> & word, int count)
+    {
+#if LIBTHREADAR_USE_FUTEX
+	if(syscall(SYS_futex, futex_word(word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0) < 0)
+	    throw exception_system("Failed waking futex waiters: ", errno);
+#endif
+    }
+
+    void futex::wake_all(atomic<int> & word)
+    {
+	wake(word, INT_MAX);
+    }
+
+    bool futex::available()
+    {
+	return LIBTHREADAR_USE_FUTEX != 0;
+    }
+
+} // end of namespace
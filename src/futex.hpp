@@ -0,0 +1,94 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_FUTEX_HPP
+#define LIBTHREADAR_FUTEX_HPP
+
+    /// \file futex.hpp
+    /// \brief defines the futex class, a thin layer over the Linux futex system call
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+#include <chrono>
+
+    // libthreadar headers
+
+namespace libthreadar
+{
+
+	/// Class futex lets threads sleep on and wake up from a 32 bits atomic word
+
+	/// This is the building block of the lightweight synchronization classes of libthreadar
+	/// (futex_mutex, ...) that only call the kernel when a thread has to be suspended or awaken.
+	/// Only the process private futex operations are used, the atomic word must thus not be
+	/// shared between processes.
+	///
+	/// On systems without futex, wait() only yields the CPU and returns, which is correct
+	/// (though less efficient) as callers must recheck the atomic word after wait() returns.
+	///
+	/// All methods are static.
+
+    class futex
+    {
+    public:
+	futex() = delete;
+
+	    /// suspend the caller as long as the word has the expected value
+
+	    /// \param[in] word the atomic word to wait on
+	    /// \param[in] expected the caller is not suspended if word has already another value
+	    /// \note may return spuriously, the caller must recheck the condition it waits for
+	static void wait(std::atomic<int> & word, int expected);
+
+	    /// suspend the caller as long as the word has the expected value, for a limited time
+
+	    /// \param[in] word the atomic word to wait on
+	    /// \param[in] expected the caller is not suspended if word has already another value
+	    /// \param[in] timeout maximum time to wait (measured on CLOCK_MONOTONIC)
+	    /// \return false if the timeout expired, true otherwise
+	    /// \note may return spuriously, the caller must recheck the condition it waits for
+	static bool wait_for(std::atomic<int> & word, int expected, std::chrono::nanoseconds timeout);
+
+	    /// awake threads waiting on the word
+
+	    /// \param[in] word the atomic word
+	    /// \param[in] count maximum number of threads to awake
+	static void wake(std::atomic<int> & word, int count = 1);
+
+	    /// awake all threads waiting on the word
+	static void wake_all(std::atomic<int> & word);
+
+	    /// whether the system provides futex (else wait() falls back to yielding the CPU)
+	static bool available();
+    };
+
+} // end of namespace
+
+#endif
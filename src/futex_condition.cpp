@@ -0,0 +1,155 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <new>
+
+    // libthreadar headers
+#include "futex.hpp"
+
+    // this module's header
+#include "futex_condition.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+    futex_condition::futex_condition(unsigned int num): num_instances(num)
+    {
+	if(num < 1)
+	    throw exception_range("need at least one instance to create a futex_condition object");
+
+	inst.reset(new (nothrow) instance_state[num]);
+	if(! inst)
+	    throw exception_memory();
+    }
+
+    void futex_condition::signal(unsigned int instance)
+    {
+	instance_state & st = get_instance(instance);
+
+	if(st.waiters.load(memory_order_relaxed) > 0)
+	{
+	    st.seq.fetch_add(1, memory_order_relaxed);
+	    futex::wake(st.seq, 1);
+	}
+    }
+
+    void futex_condition::broadcast(unsigned int instance)
+    {
+	instance_state & st = get_instance(instance);
+
+	if(st.waiters.load(memory_order_relaxed) > 0)
+	{
+	    st.seq.fetch_add(1, memory_order_relaxed);
+	    futex::wake_all(st.seq);
+	}
+    }
+
+    unsigned int futex_condition::get_waiting_thread_count(unsigned int instance) const
+    {
+	return get_instance(instance).waiters.load(memory_order_relaxed);
+    }
+
+    futex_condition::instance_state & futex_condition::get_instance(unsigned int instance) const
+    {
+	if(instance >= num_instances)
+	    throw exception_range("the instance number given to futex_condition is out of range");
+
+	return inst[instance];
+    }
+
+    bool futex_condition::wait_with(unsigned int instance, const cancellation_token *token, const chrono::steady_clock::time_point *deadline)
+    {
+	instance_state & st = get_instance(instance);
+	cancellation_token::wait_registration reg(this, &cancel_wake, instance, token);
+	bool timed_out = false;
+
+	    // reading the sequence number while holding the lock, a signal()
+	    // sent once we have released it changes the sequence number and
+	    // futex::wait() returns immediately. The cancellation flag is
+	    // checked after, see cancel_wake()
+	int seq = st.seq.load(memory_order_acquire);
+
+	st.waiters.fetch_add(1, memory_order_relaxed);
+	verrou.unlock();
+
+	try
+	{
+	    if(! reg.cancelled())
+	    {
+		if(deadline != nullptr)
+		    timed_out = ! futex::wait_for(st.seq, seq, chrono::duration_cast<chrono::nanoseconds>(*deadline - chrono::steady_clock::now()));
+		else
+		    futex::wait(st.seq, seq);
+	    }
+	}
+	catch(...)
+	{
+	    st.waiters.fetch_sub(1, memory_order_relaxed);
+	    verrou.lock();
+	    throw;
+	}
+
+	st.waiters.fetch_sub(1, memory_order_relaxed);
+	verrou.lock();
+	reg.release();
+
+	if(reg.cancelled())
+	{
+		// we may have consumed a signal() aimed at another thread
+	    signal(instance);
+	    cancellation_token::throw_cancel();
+	}
+
+	return ! timed_out;
+    }
+
+    bool futex_condition::cancel_wake(void *obj, unsigned int instance)
+    {
+	futex_condition *me = static_cast<futex_condition *>(obj);
+
+	if(me == nullptr)
+	    throw THREADAR_BUG;
+
+	    // the cancellation flag has been set before we change the sequence
+	    // number: either the waiting thread read the former sequence number
+	    // and futex::wait() returns, or it reads the new one and then sees
+	    // the flag. No lock is needed
+	instance_state & st = me->get_instance(instance);
+
+	st.seq.fetch_add(1);
+	futex::wake_all(st.seq);
+
+	return true;
+    }
+
+} // end of namespace
@@ -0,0 +1,189 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_FUTEX_CONDITION_HPP
+#define LIBTHREADAR_FUTEX_CONDITION_HPP
+
+    /// \file futex_condition.hpp
+    /// \brief defines the futex_condition class, a condition built on futex
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+#include <memory>
+#include <chrono>
+
+    // libthreadar headers
+#include "exceptions.hpp"
+#include "futex_mutex.hpp"
+#include "cancellation_token.hpp"
+
+namespace libthreadar
+{
+
+	/// Class futex_condition has the interface of libthreadar::condition without relying on pthread
+
+	/// It provides lock(), unlock(), try_lock(), wait(), wait_until(), wait_for(), signal(), broadcast()
+	/// and get_waiting_thread_count() with the same semantics as libthreadar::condition, and can thus
+	/// replace it as template argument of fast_tampon, ratelier_scatter and ratelier_gather.
+	///
+	/// The lock is a futex_mutex and each instance is a sequence number on its own cache line:
+	/// wait() reads the sequence number, releases the lock and sleeps on the sequence number
+	/// with futex, signal() and broadcast() increment it and wake threads up. Locking, unlocking
+	/// and signaling an instance nobody waits on never enter the kernel.
+	///
+	/// \note as for condition, wait() may return without signal() having been called, the
+	/// condition waited for must be checked again when wait() returns
+	/// \note the object cannot be used with lock_profiler, which only instruments libthreadar::mutex
+    class futex_condition
+    {
+    public:
+	    /// constructor
+
+	    /// \param[in] num number of instance to create, each instance is a separated condition
+	    /// relying on the same lock. First instance starts with index 0
+	futex_condition(unsigned int num = 1);
+
+	    /// no copy constructor
+	futex_condition(const futex_condition & ref) = delete;
+
+	    /// no move constructor
+	futex_condition(futex_condition && ref) = delete;
+
+	    /// no assignment operator
+	futex_condition & operator = (const futex_condition & ref) = delete;
+
+	    /// no move operator
+	futex_condition & operator = (futex_condition && ref) = delete;
+
+	    /// destructor
+	~futex_condition() = default;
+
+	    /// lock the object
+	void lock() { verrou.lock(); };
+
+	    /// unlock the object
+	void unlock() { verrou.unlock(); };
+
+	    /// lock the object if no other thread holds it
+
+	    /// \return true if lock is acquired false if the object was already locked
+	bool try_lock() { return verrou.try_lock(); };
+
+	    /// put the calling thread on hold waiting for another thread to call signal()
+
+	    /// \note see condition::wait()
+	void wait(unsigned int instance = 0) { (void)wait_with(instance, nullptr, nullptr); };
+
+	    /// same as wait() but also awaken when the given token is cancelled
+	void wait(unsigned int instance, const cancellation_token & token) { (void)wait_with(instance, &token, nullptr); };
+
+	    /// wait until the given predicate becomes true
+
+	    /// \param[in] instance the instance number to have the caller waiting on
+	    /// \param[in] pred callable object without argument returning a bool, evaluated with the lock held
+	    /// \note this is equivalent to while(!pred()) wait(instance); and thus handles spurious wake-ups
+	template <class P> void wait(unsigned int instance, P pred) { while(! pred()) wait(instance); };
+
+	    /// same as wait(instance, pred) also awaken when the given token is cancelled
+	template <class P> void wait(unsigned int instance, P pred, const cancellation_token & token) { while(! pred()) wait(instance, token); };
+
+	    /// wait until the given predicate becomes true or the deadline is reached
+
+	    /// \return the value of the predicate when the call returns
+	template <class P> bool wait_until(unsigned int instance, std::chrono::steady_clock::time_point deadline, P pred)
+	{
+	    while(! pred())
+		if(! wait_until(instance, deadline))
+		    return pred();
+	    return true;
+	};
+
+	    /// wait until the given predicate becomes true or the duration expired
+
+	    /// \return the value of the predicate when the call returns
+	template <class P> bool wait_for(unsigned int instance, std::chrono::nanoseconds duration, P pred)
+	{ return wait_until(instance, std::chrono::steady_clock::now() + duration, pred); };
+
+	    /// same as wait() but limiting the time the caller is suspended
+
+	    /// \return false if the deadline has been reached, true if awaken before
+	    /// \note see condition::wait_until()
+	bool wait_until(unsigned int instance, std::chrono::steady_clock::time_point deadline) { return wait_with(instance, nullptr, &deadline); };
+
+	    /// same as wait_until() also awaken when the given token is cancelled
+	bool wait_until(unsigned int instance, std::chrono::steady_clock::time_point deadline, const cancellation_token & token)
+	{ return wait_with(instance, &token, &deadline); };
+
+	    /// same as wait() but limiting the time the caller is suspended
+
+	    /// \return false if the duration expired, true if awaken before
+	bool wait_for(unsigned int instance, std::chrono::nanoseconds duration)
+	{ return wait_until(instance, std::chrono::steady_clock::now() + duration); };
+
+	    /// same as wait_for() also awaken when the given token is cancelled
+	bool wait_for(unsigned int instance, std::chrono::nanoseconds duration, const cancellation_token & token)
+	{ return wait_until(instance, std::chrono::steady_clock::now() + duration, token); };
+
+	    /// awakes a single thread suspended on the given instance, to be called with the lock held
+	void signal(unsigned int instance = 0);
+
+	    /// awakes all threads suspended on the given instance, to be called with the lock held
+	void broadcast(unsigned int instance = 0);
+
+	    /// return the number of thread currently waiting on that instance
+
+	    /// \note can be called without holding the lock, the returned value is then only a hint
+	unsigned int get_waiting_thread_count(unsigned int instance = 0) const;
+
+    private:
+
+	    /// state of an instance, on its own cache line
+	struct instance_state
+	{
+	    std::atomic<int> seq;               ///< incremented by signal() and broadcast()
+	    std::atomic<unsigned int> waiters;  ///< number of threads waiting on seq
+	    char pad[64 - sizeof(std::atomic<int>) - sizeof(std::atomic<unsigned int>)];
+
+	    instance_state(): seq(0), waiters(0) {};
+	};
+
+	futex_mutex verrou;                      ///< the lock
+	unsigned int num_instances;              ///< number of instances
+	std::unique_ptr<instance_state[]> inst;  ///< the instances
+
+	instance_state & get_instance(unsigned int instance) const;
+	bool wait_with(unsigned int instance, const cancellation_token *token, const std::chrono::steady_clock::time_point *deadline);
+
+	static bool cancel_wake(void *obj, unsigned int instance);
+    };
+
+} // end of namespace
+
+#endif
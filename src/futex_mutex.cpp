@@ -0,0 +1,78 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+
+    // libthreadar headers
+
+    // this module's header
+#include "futex_mutex.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+    static_assert(sizeof(futex_mutex) == sizeof(int), "futex_mutex should be a single 32 bits word");
+
+	// number of times the state is polled before suspending the caller
+    static const unsigned int spin_count = 100;
+
+    void futex_mutex::lock_contended(int current)
+    {
+	    // a short spin first, the holder may release the lock soon
+	    // when the critical section is short
+
+	for(unsigned int i = 0; i < spin_count && current == locked; ++i)
+	{
+	    current = state.load(memory_order_relaxed);
+	    if(current == unlocked)
+	    {
+		if(state.compare_exchange_weak(current, locked, memory_order_acquire, memory_order_relaxed))
+		    return;
+	    }
+	}
+
+	    // from now on the state is set to contended, so that the thread
+	    // unlocking the mutex knows it has to wake a waiter. Acquiring the
+	    // mutex that way may lead to a useless wake up at the next unlock()
+	    // but no wake up can be lost
+
+	if(current != contended)
+	    current = state.exchange(contended, memory_order_acquire);
+
+	while(current != unlocked)
+	{
+	    futex::wait(state, contended);
+	    current = state.exchange(contended, memory_order_acquire);
+	}
+    }
+
+} // end of namespace
@@ -0,0 +1,116 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_FUTEX_MUTEX_HPP
+#define LIBTHREADAR_FUTEX_MUTEX_HPP
+
+    /// \file futex_mutex.hpp
+    /// \brief defines the futex_mutex class, a 4 bytes mutex relying on futex
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+
+    // libthreadar headers
+#include "futex.hpp"
+
+namespace libthreadar
+{
+
+	/// Class futex_mutex is a lightweight alternative to libthreadar::mutex
+
+	/// It has the same lock(), unlock() and try_lock() methods as libthreadar::mutex but
+	/// holds a single 32 bits atomic word: locking an available futex_mutex costs a
+	/// single compare-and-swap and unlocking it a single atomic exchange, both inlined
+	/// in the caller. The kernel is only called when a thread has to be suspended
+	/// because the mutex is held, or when unlocking a mutex some threads are waiting for.
+	///
+	/// \note at the difference of libthreadar::mutex, there is no error checking: unlocking
+	/// a futex_mutex not locked or locking it twice from the same thread is undefined behavior
+	/// \note futex_mutex cannot be used with libthreadar::condition, which relies on a pthread_mutex_t
+    class futex_mutex
+    {
+    public:
+	    /// constructor
+	futex_mutex(): state(0) {};
+
+	    /// no copy constructor
+	futex_mutex(const futex_mutex & ref) = delete;
+
+	    /// no move constructor
+	futex_mutex(futex_mutex && ref) = delete;
+
+	    /// no assignment operator
+	futex_mutex & operator = (const futex_mutex & ref) = delete;
+
+	    /// no move operator
+	futex_mutex & operator = (futex_mutex && ref) = delete;
+
+	    /// destructor
+	~futex_mutex() = default;
+
+	    /// lock the mutex, suspending the caller if another thread holds it
+	void lock()
+	{
+	    int expected = unlocked;
+
+	    if(! state.compare_exchange_strong(expected, locked, std::memory_order_acquire, std::memory_order_relaxed))
+		lock_contended(expected);
+	};
+
+	    /// unlock the mutex, awaking one of the threads waiting for it if any
+	void unlock()
+	{
+	    if(state.exchange(unlocked, std::memory_order_release) == contended)
+		futex::wake(state, 1);
+	};
+
+	    /// acquire the mutex if available without suspending the caller
+
+	    /// \return true if lock is acquired false if mutex was already locked
+	bool try_lock()
+	{
+	    int expected = unlocked;
+
+	    return state.compare_exchange_strong(expected, locked, std::memory_order_acquire, std::memory_order_relaxed);
+	};
+
+    private:
+	static const int unlocked = 0;   ///< mutex available
+	static const int locked = 1;     ///< mutex held, no thread suspended
+	static const int contended = 2;  ///< mutex held, some threads may be suspended
+
+	std::atomic<int> state;          ///< one of the three values above
+
+	void lock_contended(int current);
+    };
+
+} // end of namespace
+
+#endif
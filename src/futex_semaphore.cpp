@@ -0,0 +1,146 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+
+    // libthreadar headers
+#include "futex.hpp"
+#include "tools.hpp"
+
+    // this module's header
+#include "futex_semaphore.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+    static const unsigned int spin_count = 100;
+
+    futex_semaphore::futex_semaphore(unsigned int initial): count(0), waiters(0)
+    {
+	if(initial > max_tokens)
+	    throw exception_range("initial value too large for futex_semaphore");
+	count.store(int(initial));
+    }
+
+    bool futex_semaphore::acquire_with(unsigned int n, const cancellation_token *token, const chrono::steady_clock::time_point *deadline)
+    {
+	    // a short spin first, tokens are often released soon
+	    // when they protect short operations
+
+	for(unsigned int i = 0; i < spin_count; ++i)
+	{
+	    if((count.load(memory_order_relaxed) & value_mask) >= int(n) && try_acquire(n))
+		return true;
+	    tools_cpu_relax();
+	}
+
+	waiters.fetch_add(1, memory_order_relaxed);
+
+	try
+	{
+	    cancellation_token::wait_registration reg(this, &cancel_wake, 0, token);
+
+	    while(true)
+	    {
+		    // reading the counter before checking the cancellation flag, see cancel_wake()
+		int cur = count.load(memory_order_acquire);
+
+		if((cur & value_mask) >= int(n))
+		{
+		    if(count.compare_exchange_weak(cur, cur - int(n), memory_order_acquire, memory_order_relaxed))
+			break;
+		    continue;
+		}
+
+		if(reg.cancelled())
+		    cancellation_token::throw_cancel();
+
+		    // telling release() it has to wake us, if the counter changes
+		    // meanwhile the compare-and-swap fails and we check again
+		if((cur & sleeper_bit) == 0)
+		{
+		    if(! count.compare_exchange_strong(cur, cur | sleeper_bit))
+			continue;
+		    cur |= sleeper_bit;
+		}
+
+		if(deadline != nullptr)
+		{
+		    chrono::steady_clock::duration remaining = *deadline - chrono::steady_clock::now();
+
+		    if(remaining <= chrono::steady_clock::duration::zero())
+		    {
+			reg.release();
+			waiters.fetch_sub(1, memory_order_relaxed);
+			return false;
+		    }
+		    (void)futex::wait_for(count, cur, chrono::duration_cast<chrono::nanoseconds>(remaining));
+		}
+		else
+		    futex::wait(count, cur);
+	    }
+	}
+	catch(...)
+	{
+	    waiters.fetch_sub(1, memory_order_relaxed);
+	    throw;
+	}
+
+	waiters.fetch_sub(1, memory_order_relaxed);
+
+	return true;
+    }
+
+    void futex_semaphore::wake_sleepers(atomic<int> & word)
+    {
+	    // the sleeper bit has been cleared, every sleeping thread has to be
+	    // awaken: one asking for less tokens than another may be able to proceed
+	futex::wake_all(word);
+    }
+
+    bool futex_semaphore::cancel_wake(void *obj, unsigned int)
+    {
+	futex_semaphore *me = static_cast<futex_semaphore *>(obj);
+
+	if(me == nullptr)
+	    throw THREADAR_BUG;
+
+	    // the cancellation flag is set before we change the futex word:
+	    // either the waiting thread read the former value and futex::wait()
+	    // returns, or it reads the new one and then sees the flag
+	me->count.fetch_xor(cancel_bit);
+	futex::wake_all(me->count);
+
+	return true;
+    }
+
+} // end of namespace
@@ -0,0 +1,185 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_FUTEX_SEMAPHORE_HPP
+#define LIBTHREADAR_FUTEX_SEMAPHORE_HPP
+
+    /// \file futex_semaphore.hpp
+    /// \brief defines the futex_semaphore class, a counting semaphore built on an atomic counter and futex
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+#include <chrono>
+
+    // libthreadar headers
+#include "exceptions.hpp"
+#include "cancellation_token.hpp"
+
+namespace libthreadar
+{
+
+	/// Class futex_semaphore is a counting semaphore acquiring and releasing tokens by batch
+
+	/// The number of available tokens is a single atomic counter: acquiring tokens when
+	/// enough are available is a compare-and-swap inlined in the caller, releasing tokens
+	/// is an atomic addition, the kernel being only called to suspend a thread when not
+	/// enough tokens are available, or to wake it up when some thread is waiting.
+	///
+	/// At the difference of libthreadar::semaphore, there is no maximum value and the value
+	/// never gets negative: it is the number of tokens available, which is typically the number
+	/// of operations allowed to be in flight at a given time.
+	///
+	/// \note acquire() is a cancellation point for libthreadar threads like condition::wait()
+	/// \note a thread asking for a large batch may wait long if other threads keep acquiring
+	/// small batches, there is no fairness between waiting threads
+	/// \note a thread may destroy the object once it has acquired tokens, even if the thread that
+	/// released them has not yet returned from release(): release() does not access the object
+	/// after adding the tokens, the futex wake-up excepted, which does not dereference it
+	/// \note the number of available tokens cannot exceed 0x1FFFFFFF, release() throws
+	/// exception_range if it would
+    class futex_semaphore
+    {
+    public:
+	    /// constructor
+
+	    /// \param[in] initial number of tokens available at creation time, at most 0x1FFFFFFF
+	futex_semaphore(unsigned int initial = 0);
+
+	    /// no copy constructor
+	futex_semaphore(const futex_semaphore & ref) = delete;
+
+	    /// no move constructor
+	futex_semaphore(futex_semaphore && ref) = delete;
+
+	    /// no assignment operator
+	futex_semaphore & operator = (const futex_semaphore & ref) = delete;
+
+	    /// no move operator
+	futex_semaphore & operator = (futex_semaphore && ref) = delete;
+
+	    /// destructor
+	~futex_semaphore() = default;
+
+	    /// acquire n tokens, suspending the caller until they are available
+	void acquire(unsigned int n = 1)
+	{
+	    if(! try_acquire(n))
+		(void)acquire_with(n, nullptr, nullptr);
+	};
+
+	    /// same as acquire() but also awaken when the given token is cancelled
+
+	    /// thread::cancel_except is then thrown and no token is acquired
+	void acquire(unsigned int n, const cancellation_token & token)
+	{
+	    if(! try_acquire(n))
+		(void)acquire_with(n, &token, nullptr);
+	};
+
+	    /// acquire n tokens if they are available without suspending the caller
+
+	    /// \return true if the tokens have been acquired, false else (no token is then acquired)
+	bool try_acquire(unsigned int n = 1)
+	{
+	    int cur = count.load(std::memory_order_relaxed);
+
+	    if(n > max_tokens)
+		throw exception_range("too many tokens requested from a futex_semaphore");
+
+		// the flag bits are left unchanged by the subtraction
+	    while((cur & value_mask) >= int(n))
+		if(count.compare_exchange_weak(cur, cur - int(n), std::memory_order_acquire, std::memory_order_relaxed))
+		    return true;
+
+	    return false;
+	};
+
+	    /// acquire n tokens, suspending the caller up to the given deadline
+
+	    /// \return true if the tokens have been acquired, false if the deadline has been reached
+	bool acquire_until(std::chrono::steady_clock::time_point deadline, unsigned int n = 1)
+	{ return try_acquire(n) || acquire_with(n, nullptr, &deadline); };
+
+	    /// same as acquire_until() also awaken when the given token is cancelled
+	bool acquire_until(std::chrono::steady_clock::time_point deadline, unsigned int n, const cancellation_token & token)
+	{ return try_acquire(n) || acquire_with(n, &token, &deadline); };
+
+	    /// acquire n tokens, suspending the caller at most for the given duration
+
+	    /// \return true if the tokens have been acquired, false if the duration expired
+	bool acquire_for(std::chrono::nanoseconds duration, unsigned int n = 1)
+	{ return acquire_until(std::chrono::steady_clock::now() + duration, n); };
+
+	    /// release n tokens, awaking the threads waiting for them if any
+	void release(unsigned int n = 1)
+	{
+	    int cur = count.load(std::memory_order_relaxed);
+	    int next;
+
+		// clearing the sleeper bit, all sleeping threads are awaken below
+		// and those still missing tokens set it again before sleeping
+	    do
+	    {
+		if(n > max_tokens - (unsigned int)(cur & value_mask))
+		    throw exception_range("too many tokens released to a futex_semaphore");
+		next = (cur + int(n)) & ~sleeper_bit;
+	    }
+	    while(! count.compare_exchange_weak(cur, next, std::memory_order_release, std::memory_order_relaxed));
+
+		// the object may have been destroyed by a thread that got the tokens,
+		// nothing but the futex address is used from here
+	    if((cur & sleeper_bit) != 0)
+		wake_sleepers(count);
+	};
+
+	    /// number of tokens currently available
+	int get_value() const { return count.load(std::memory_order_relaxed) & value_mask; };
+
+	    /// number of threads suspended waiting for tokens (only a hint)
+	unsigned int get_waiting_thread_count() const { return waiters.load(std::memory_order_relaxed); };
+
+    private:
+	static const int value_mask = 0x1FFFFFFF;   ///< bits of count holding the number of tokens
+	static const int cancel_bit = 0x20000000;   ///< toggled by cancel_wake() to change the futex word
+	static const int sleeper_bit = 0x40000000;  ///< set by threads before sleeping in acquire_with()
+	static const unsigned int max_tokens = value_mask; ///< largest number of available tokens
+
+	std::atomic<int> count;             ///< number of tokens available and the above flags, futex word
+	std::atomic<unsigned int> waiters;  ///< number of threads in acquire_with(), only a hint
+
+	bool acquire_with(unsigned int n, const cancellation_token *token, const std::chrono::steady_clock::time_point *deadline);
+
+	static void wake_sleepers(std::atomic<int> & word);
+	static bool cancel_wake(void *obj, unsigned int instance);
+    };
+
+} // end of namespace
+
+#endif
@@ -0,0 +1,126 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+
+    // libthreadar headers
+#include "futex.hpp"
+
+    // this module's header
+#include "latch.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+    latch::latch(unsigned int num): count(0)
+    {
+	if(num > (unsigned int)value_mask)
+	    throw exception_range("latch counter too large");
+	count.store(int(num));
+    }
+
+    void latch::count_down(unsigned int n)
+    {
+	int cur = count.load(memory_order_relaxed);
+
+	do
+	{
+	    if(n > (unsigned int)(cur & value_mask))
+		throw exception_range("latch counted down below zero");
+	}
+	while(! count.compare_exchange_weak(cur, cur - int(n)));
+
+	    // a waiting thread may have seen the counter at zero and destroyed
+	    // the object by now, only the futex address is used from here,
+	    // the kernel does not dereference it when nobody sleeps on it
+	if(n > 0 && (cur & value_mask) == int(n) && (cur & sleeper_bit) != 0)
+	    futex::wake_all(count);
+    }
+
+    bool latch::wait_with(const cancellation_token *token, const chrono::steady_clock::time_point *deadline)
+    {
+	if(try_wait())
+	    return true;
+
+	cancellation_token::wait_registration reg(this, &cancel_wake, 0, token);
+
+	while(true)
+	{
+		// reading the counter before checking the cancellation flag, see cancel_wake()
+	    int cur = count.load();
+
+	    if((cur & value_mask) == 0)
+		return true;
+
+	    if(reg.cancelled())
+		cancellation_token::throw_cancel();
+
+		// telling count_down() it has to wake us, if the counter changes
+		// meanwhile the compare-and-swap fails and we check again
+	    if((cur & sleeper_bit) == 0)
+	    {
+		if(! count.compare_exchange_strong(cur, cur | sleeper_bit))
+		    continue;
+		cur |= sleeper_bit;
+	    }
+
+	    if(deadline != nullptr)
+	    {
+		chrono::steady_clock::duration remaining = *deadline - chrono::steady_clock::now();
+
+		if(remaining <= chrono::steady_clock::duration::zero())
+		    return false;
+		(void)futex::wait_for(count, cur, chrono::duration_cast<chrono::nanoseconds>(remaining));
+	    }
+	    else
+		futex::wait(count, cur);
+	}
+    }
+
+    bool latch::cancel_wake(void *obj, unsigned int)
+    {
+	latch *me = static_cast<latch *>(obj);
+
+	if(me == nullptr)
+	    throw THREADAR_BUG;
+
+	    // the cancellation flag is set before we change the futex word:
+	    // either the waiting thread read the former value and futex::wait()
+	    // returns, or it reads the new one and then sees the flag. The object
+	    // cannot be destroyed meanwhile as the waiting thread is registered
+	me->count.fetch_xor(cancel_bit);
+	futex::wake_all(me->count);
+
+	return true;
+    }
+
+} // end of namespace
@@ -0,0 +1,139 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_LATCH_HPP
+#define LIBTHREADAR_LATCH_HPP
+
+    /// \file latch.hpp
+    /// \brief defines the latch class, a one-shot countdown threads can wait on
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+#include <chrono>
+
+    // libthreadar headers
+#include "exceptions.hpp"
+#include "cancellation_token.hpp"
+
+namespace libthreadar
+{
+
+	/// Class latch lets threads wait for a counter to reach zero
+
+	/// The counter is set at construction time and decremented by count_down(), usually
+	/// once per task or worker completing. Threads calling wait() are suspended until it
+	/// reaches zero, after which wait() returns immediately: the latch cannot be reset,
+	/// use a phaser for repeated synchronizations.
+	///
+	/// At the difference of a barrier, the threads counting down do not need to wait
+	/// and their number does not need to be known when the latch is waited on.
+	/// count_down() is a single atomic operation, the kernel being only called when
+	/// reaching zero while threads are suspended.
+	///
+	/// \note a thread returning from wait() may destroy the latch while the thread that
+	/// brought the counter to zero is still in count_down(): count_down() does not access
+	/// the object once the counter is decremented, the futex wake-up excepted, which does
+	/// not dereference it. The latch must however outlive any count_down() call that does
+	/// not bring the counter to zero, as well as the threads suspended in wait().
+	/// \note wait() is a cancellation point for libthreadar threads like condition::wait()
+    class latch
+    {
+    public:
+	    /// constructor
+
+	    /// \param[in] num number of count_down() to wait for, at most 0x1FFFFFFF
+	latch(unsigned int num);
+
+	    /// no copy constructor
+	latch(const latch & ref) = delete;
+
+	    /// no move constructor
+	latch(latch && ref) = delete;
+
+	    /// no assignment operator
+	latch & operator = (const latch & ref) = delete;
+
+	    /// no move operator
+	latch & operator = (latch && ref) = delete;
+
+	    /// destructor
+
+	    /// \note the object must not be destroyed while threads are suspended in wait()
+	~latch() = default;
+
+	    /// decrement the counter, awaking the waiting threads when it reaches zero
+
+	    /// \param[in] n the amount to decrement the counter of
+	    /// \note decrementing more than the current counter value throws exception_range
+	void count_down(unsigned int n = 1);
+
+	    /// whether the counter has reached zero
+	bool try_wait() const { return (count.load(std::memory_order_acquire) & value_mask) == 0; };
+
+	    /// suspend the caller until the counter reaches zero
+	void wait() { (void)wait_with(nullptr, nullptr); };
+
+	    /// same as wait() but also awaken when the given token is cancelled
+	void wait(const cancellation_token & token) { (void)wait_with(&token, nullptr); };
+
+	    /// suspend the caller until the counter reaches zero or the deadline is reached
+
+	    /// \return true if the counter reached zero, false if the deadline has been reached
+	bool wait_until(std::chrono::steady_clock::time_point deadline) { return wait_with(nullptr, &deadline); };
+
+	    /// same as wait_until() also awaken when the given token is cancelled
+	bool wait_until(std::chrono::steady_clock::time_point deadline, const cancellation_token & token) { return wait_with(&token, &deadline); };
+
+	    /// suspend the caller until the counter reaches zero or the duration expired
+
+	    /// \return true if the counter reached zero, false if the duration expired
+	bool wait_for(std::chrono::nanoseconds duration) { return wait_until(std::chrono::steady_clock::now() + duration); };
+
+	    /// decrement the counter then wait for it to reach zero
+	void arrive_and_wait(unsigned int n = 1) { count_down(n); wait(); };
+
+	    /// current counter value
+	unsigned int get_count() const { return count.load(std::memory_order_relaxed) & value_mask; };
+
+    private:
+	static const int value_mask = 0x1FFFFFFF;  ///< bits of count holding the counter value
+	static const int cancel_bit = 0x20000000;  ///< toggled by cancel_wake() to change the futex word
+	static const int sleeper_bit = 0x40000000; ///< set by threads before sleeping in wait()
+
+	std::atomic<int> count;  ///< number of count_down() still expected and the above flags, futex word
+
+	bool wait_with(const cancellation_token *token, const std::chrono::steady_clock::time_point *deadline);
+
+	static bool cancel_wake(void *obj, unsigned int instance);
+    };
+
+} // end of namespace
+
+#endif
@@ -31,16 +31,35 @@
     /// \par Description
     /// This is the documentation pages of Libthreadar, a C++ library which provides several classes to manipulate threads:
     /// - \link libthreadar::barrier class barrier\endlink
+    /// - \link libthreadar::spin_barrier class spin_barrier\endlink and \link libthreadar::tree_barrier class tree_barrier\endlink
+    /// - \link libthreadar::latch class latch\endlink and \link libthreadar::phaser class phaser\endlink
     /// - \link libthreadar::freezer class freezer\endlink
     /// - \link libthreadar::mutex class mutex\endlink
+    /// - \link libthreadar::futex_mutex class futex_mutex\endlink
+    /// - \link libthreadar::spin_mutex class spin_mutex\endlink
+    /// - \link libthreadar::ticket_mutex class ticket_mutex\endlink
+    /// - \link libthreadar::mcs_mutex class mcs_mutex\endlink
+    /// - \link libthreadar::rwlock class rwlock\endlink
+    /// - \link libthreadar::seqlock class seqlock\endlink
+    /// - \link libthreadar::lock_profiler class lock_profiler\endlink
     /// - \link libthreadar::semaphore class semaphore\endlink
+    /// - \link libthreadar::futex_semaphore class futex_semaphore\endlink
     /// - \link libthreadar::fast_tampon class fast_tampon\endlink
     /// - \link libthreadar::thread class thread\endlink
     /// - \link libthreadar::thread_signal class thread_signal\endlink
     /// - \link libthreadar::freezer class freezer\endlink
     /// - \link libthreadar::condition class condition\endlink
+    /// - \link libthreadar::futex_condition class futex_condition\endlink
+    /// - \link libthreadar::lock_guard class lock_guard\endlink and \link libthreadar::shared_lock_guard class shared_lock_guard\endlink
     /// - \link libthreadar::ratelier_gather class ratelier_gather\endlink
     /// - \link libthreadar::ratelier_scatter class ratelier_scatter\endlink
+    /// - \link libthreadar::ordered_pipeline class ordered_pipeline\endlink
+    /// - \link libthreadar::thread_pool class thread_pool\endlink
+    /// - \link libthreadar::cpu_topology class cpu_topology\endlink
+    /// - \link libthreadar::stack_pool class stack_pool\endlink
+    /// - \link libthreadar::cancellation_token class cancellation_token\endlink
+    /// - \link parallel_for.hpp functions parallel_for() and parallel_reduce()\endlink
+    /// - \link libthreadar::task_graph class task_graph\endlink
     /// .
     /// These classes are independent from each others (even if some inherit from some others like libthreadar::condition from libthreadar::mutex)
     /// and are defined within the \ref libthreadar namespace.
@@ -80,6 +99,28 @@
 #include "freezer.hpp"
 #include "ratelier_gather.hpp"
 #include "ratelier_scatter.hpp"
+#include "ordered_pipeline.hpp"
+#include "thread_pool.hpp"
+#include "cpu_topology.hpp"
+#include "stack_pool.hpp"
+#include "cancellation_token.hpp"
+#include "parallel_for.hpp"
+#include "task_graph.hpp"
+#include "futex.hpp"
+#include "futex_mutex.hpp"
+#include "spin_mutex.hpp"
+#include "ticket_mutex.hpp"
+#include "mcs_mutex.hpp"
+#include "rwlock.hpp"
+#include "seqlock.hpp"
+#include "lock_profiler.hpp"
+#include "futex_condition.hpp"
+#include "lock_guard.hpp"
+#include "futex_semaphore.hpp"
+#include "spin_barrier.hpp"
+#include "tree_barrier.hpp"
+#include "latch.hpp"
+#include "phaser.hpp"
 
    /// This is the only namespace used in libthreadar and all symbols provided by libthreadar are member of this namespace.
 
@@ -0,0 +1,121 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_LOCK_GUARD_HPP
+#define LIBTHREADAR_LOCK_GUARD_HPP
+
+    /// \file lock_guard.hpp
+    /// \brief defines the lock_guard and shared_lock_guard templates that release a lock when leaving a scope
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+
+    // libthreadar headers
+
+namespace libthreadar
+{
+
+	/// Class lock_guard locks an object at construction time and unlocks it at destruction time
+
+	/// It avoids the try/catch block around a critical section to release the lock when an exception
+	/// is thrown:
+	/** \verbatim
+	    {
+	        lock_guard<condition> lock(verrou);
+	        verrou.wait(0, [this]() { return ! queue.empty(); });
+	        ... // the lock is held here
+	    } // the lock is released here, also if an exception has been thrown
+	    \endverbatim **/
+	///
+	/// L is any class with lock() and unlock() methods: mutex, condition, futex_mutex, futex_condition,
+	/// spin_mutex, ticket_mutex, mcs_mutex, rwlock...
+    template <class L> class lock_guard
+    {
+    public:
+	    /// lock the given object up to the destruction of the lock_guard
+	explicit lock_guard(L & ref): obj(ref) { obj.lock(); held = true; };
+
+	    /// no copy constructor
+	lock_guard(const lock_guard & ref) = delete;
+
+	    /// no assignment operator
+	lock_guard & operator = (const lock_guard & ref) = delete;
+
+	    /// release the lock if still held
+	~lock_guard() { if(held) { try { obj.unlock(); } catch(...) {} } };
+
+	    /// release the lock before the end of the scope
+	void unlock() { if(held) { held = false; obj.unlock(); } };
+
+	    /// acquire the lock again after unlock()
+	void lock() { if(! held) { obj.lock(); held = true; } };
+
+	    /// whether the lock is currently held
+	bool owns_lock() const { return held; };
+
+    private:
+	L & obj;
+	bool held;
+    };
+
+	/// Class shared_lock_guard acquires a reader lock (see rwlock) for the time of a scope
+
+	/// L is any class with lock_shared() and unlock_shared() methods
+    template <class L> class shared_lock_guard
+    {
+    public:
+	    /// lock the given object for reading up to the destruction of the shared_lock_guard
+	explicit shared_lock_guard(L & ref): obj(ref) { obj.lock_shared(); held = true; };
+
+	    /// no copy constructor
+	shared_lock_guard(const shared_lock_guard & ref) = delete;
+
+	    /// no assignment operator
+	shared_lock_guard & operator = (const shared_lock_guard & ref) = delete;
+
+	    /// release the lock if still held
+	~shared_lock_guard() { if(held) { try { obj.unlock_shared(); } catch(...) {} } };
+
+	    /// release the lock before the end of the scope
+	void unlock() { if(held) { held = false; obj.unlock_shared(); } };
+
+	    /// acquire the lock again after unlock()
+	void lock() { if(! held) { obj.lock_shared(); held = true; } };
+
+	    /// whether the lock is currently held
+	bool owns_lock() const { return held; };
+
+    private:
+	L & obj;
+	bool held;
+    };
+
+} // end of namespace
+
+#endif
@@ -0,0 +1,336 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <list>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <algorithm>
+
+    // libthreadar headers
+#include "exceptions.hpp"
+#include "futex_mutex.hpp"
+
+    // this module's header
+#include "lock_profiler.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+	/// statistics of an object, fields are updated without lock
+	/// except label and alive protected by the registry lock
+
+    struct lock_profiler::record
+    {
+	string label;
+	bool alive;
+	atomic<unsigned long> contended;
+	atomic<unsigned long> contended_sampled;
+	atomic<unsigned long> contended_ns;
+	atomic<unsigned long> max_ns;
+	atomic<unsigned long> waits;
+	atomic<unsigned long> waits_sampled;
+	atomic<unsigned long> waits_ns;
+
+	record(): alive(true), contended(0), contended_sampled(0), contended_ns(0), max_ns(0), waits(0), waits_sampled(0), waits_ns(0) {};
+
+	void zero()
+	{
+	    contended.store(0);
+	    contended_sampled.store(0);
+	    contended_ns.store(0);
+	    max_ns.store(0);
+	    waits.store(0);
+	    waits_sampled.store(0);
+	    waits_ns.store(0);
+	};
+    };
+
+    namespace
+    {
+	    // the registry relies on a futex_mutex, not a libthreadar::mutex
+	    // that would be profiled itself
+
+	struct registry
+	{
+	    futex_mutex control;                              ///< protects the list and records labels
+	    list<unique_ptr<lock_profiler::record> > records; ///< all records ever created, up to reset()
+	};
+
+	registry & profiler_registry()
+	{
+	    static registry *ptr = new registry();
+
+		// never destroyed: static mutex objects may
+		// retire their record at process end
+	    return *ptr;
+	}
+
+	unsigned long estimate(unsigned long sampled_total, unsigned long sampled, unsigned long all)
+	{
+	    if(sampled == 0)
+		return 0;
+	    else
+		return (unsigned long)((double)sampled_total / sampled * all);
+	}
+    }
+
+    atomic<unsigned int> lock_profiler::sampling(0);
+
+    void lock_profiler::enable(unsigned int val)
+    {
+	if(val == 0)
+	    throw exception_range("lock_profiler sampling must not be zero");
+	sampling.store(val, memory_order_relaxed);
+    }
+
+    void lock_profiler::disable()
+    {
+	sampling.store(0, memory_order_relaxed);
+    }
+
+    vector<lock_profiler::entry> lock_profiler::report(unsigned int top)
+    {
+	registry & reg = profiler_registry();
+	vector<entry> ret;
+
+	reg.control.lock();
+	try
+	{
+	    for(list<unique_ptr<record> >::iterator it = reg.records.begin(); it != reg.records.end(); ++it)
+	    {
+		entry ent;
+		record & rec = **it;
+
+		ent.label = rec.label;
+		ent.alive = rec.alive;
+		ent.contended = rec.contended.load();
+		ent.contended_sampled = rec.contended_sampled.load();
+		ent.contended_wait = chrono::nanoseconds(estimate(rec.contended_ns.load(), ent.contended_sampled, ent.contended));
+		ent.max_wait = chrono::nanoseconds(rec.max_ns.load());
+		ent.waits = rec.waits.load();
+		ent.waits_sampled = rec.waits_sampled.load();
+		ent.condition_wait = chrono::nanoseconds(estimate(rec.waits_ns.load(), ent.waits_sampled, ent.waits));
+
+		if(ent.contended > 0 || ent.waits > 0)
+		    ret.push_back(ent);
+	    }
+	}
+	catch(...)
+	{
+	    reg.control.unlock();
+	    throw;
+	}
+	reg.control.unlock();
+
+	sort(ret.begin(), ret.end(),
+	     [](const entry & a, const entry & b)
+	     {
+		 if(a.contended_wait != b.contended_wait)
+		     return a.contended_wait > b.contended_wait;
+		 else
+		     return a.contended > b.contended;
+	     });
+
+	if(top > 0 && ret.size() > top)
+	    ret.resize(top);
+
+	return ret;
+    }
+
+    void lock_profiler::reset()
+    {
+	registry & reg = profiler_registry();
+
+	reg.control.lock();
+	list<unique_ptr<record> >::iterator it = reg.records.begin();
+	while(it != reg.records.end())
+	{
+	    if(! (*it)->alive)
+		it = reg.records.erase(it);
+	    else
+	    {
+		(*it)->zero();
+		++it;
+	    }
+	}
+	reg.control.unlock();
+    }
+
+    bool lock_profiler::take_sample()
+    {
+	static thread_local unsigned int count = 0;
+	unsigned int every = sampling.load(memory_order_relaxed);
+
+	if(every <= 1)
+	    return true;
+
+	if(++count >= every)
+	{
+	    count = 0;
+	    return true;
+	}
+	else
+	    return false;
+    }
+
+    lock_profiler::record *lock_profiler::get_record(atomic<record *> & slot, const void *obj)
+    {
+	record *ret = slot.load(memory_order_acquire);
+
+	if(ret != nullptr)
+	    return ret;
+
+	registry & reg = profiler_registry();
+
+	reg.control.lock();
+	try
+	{
+	    ret = slot.load(memory_order_acquire);
+	    if(ret == nullptr)
+	    {
+		ostringstream label;
+
+		reg.records.push_back(unique_ptr<record>(new (nothrow) record()));
+		ret = reg.records.back().get();
+		if(ret == nullptr)
+		{
+		    reg.records.pop_back();
+		    throw exception_memory();
+		}
+		label << obj;
+		ret->label = label.str();
+		slot.store(ret, memory_order_release);
+	    }
+	}
+	catch(...)
+	{
+	    reg.control.unlock();
+	    throw;
+	}
+	reg.control.unlock();
+
+	return ret;
+    }
+
+    void lock_profiler::set_label(atomic<record *> & slot, const void *obj, const string & label)
+    {
+	record *rec = get_record(slot, obj);
+	registry & reg = profiler_registry();
+
+	reg.control.lock();
+	try
+	{
+	    rec->label = label;
+	}
+	catch(...)
+	{
+	    reg.control.unlock();
+	    throw;
+	}
+	reg.control.unlock();
+    }
+
+    string lock_profiler::get_label(const atomic<record *> & slot, const void *obj)
+    {
+	record *rec = slot.load(memory_order_acquire);
+	registry & reg = profiler_registry();
+	string ret;
+
+	if(rec == nullptr)
+	{
+	    ostringstream label;
+
+	    label << obj;
+	    return label.str();
+	}
+
+	reg.control.lock();
+	try
+	{
+	    ret = rec->label;
+	}
+	catch(...)
+	{
+	    reg.control.unlock();
+	    throw;
+	}
+	reg.control.unlock();
+
+	return ret;
+    }
+
+    void lock_profiler::retire(atomic<record *> & slot)
+    {
+	record *rec = slot.load(memory_order_acquire);
+
+	if(rec != nullptr)
+	{
+	    registry & reg = profiler_registry();
+
+	    reg.control.lock();
+	    rec->alive = false;
+	    reg.control.unlock();
+	}
+    }
+
+    void lock_profiler::contended(atomic<record *> & slot, const void *obj, bool sampled, chrono::nanoseconds waited)
+    {
+	record *rec = get_record(slot, obj);
+
+	rec->contended.fetch_add(1, memory_order_relaxed);
+	if(sampled)
+	{
+	    unsigned long ns = waited.count();
+	    unsigned long max = rec->max_ns.load(memory_order_relaxed);
+
+	    rec->contended_sampled.fetch_add(1, memory_order_relaxed);
+	    rec->contended_ns.fetch_add(ns, memory_order_relaxed);
+	    while(ns > max && ! rec->max_ns.compare_exchange_weak(max, ns, memory_order_relaxed))
+		;
+	}
+    }
+
+    void lock_profiler::waited(atomic<record *> & slot, const void *obj, bool sampled, chrono::nanoseconds waited)
+    {
+	record *rec = get_record(slot, obj);
+
+	rec->waits.fetch_add(1, memory_order_relaxed);
+	if(sampled)
+	{
+	    rec->waits_sampled.fetch_add(1, memory_order_relaxed);
+	    rec->waits_ns.fetch_add(waited.count(), memory_order_relaxed);
+	}
+    }
+
+} // end of namespace
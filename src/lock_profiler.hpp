@@ -0,0 +1,126 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_LOCK_PROFILER_HPP
+#define LIBTHREADAR_LOCK_PROFILER_HPP
+
+    /// \file lock_profiler.hpp
+    /// \brief defines the lock_profiler class that measures the contention of mutex and condition objects
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+    // libthreadar headers
+
+namespace libthreadar
+{
+
+	/// Class lock_profiler records which libthreadar::mutex and libthreadar::condition objects are contended
+
+	/// Profiling is disabled by default and costs a single atomic read per mutex::lock() call.
+	/// Once enabled by enable(), mutex::lock() first tries to acquire the lock without waiting and,
+	/// if the lock is held by another thread, counts the contention for that mutex and measures
+	/// the time spent waiting for it. condition::wait() counts the waits and measures their
+	/// duration the same way. To keep the overhead low, only one contention (or wait) out of
+	/// 'sampling' is timed, the total waiting time being estimated from these samples.
+	///
+	/// Mutex and condition objects can be given a label (see mutex::set_label()) to be identified
+	/// in the report, by default they are reported by their address.
+	///
+	/// All methods are static.
+
+    class lock_profiler
+    {
+    public:
+	    /// statistics of a mutex or condition object
+	struct entry
+	{
+	    std::string label;                       ///< label of the object
+	    bool alive;                              ///< false if the object has been destroyed
+	    unsigned long contended;                 ///< number of lock() calls that had to wait
+	    unsigned long contended_sampled;         ///< number of these waits that have been timed
+	    std::chrono::nanoseconds contended_wait; ///< estimated total time spent waiting in lock()
+	    std::chrono::nanoseconds max_wait;       ///< longest timed wait in lock()
+	    unsigned long waits;                     ///< number of condition::wait() calls
+	    unsigned long waits_sampled;             ///< number of these calls that have been timed
+	    std::chrono::nanoseconds condition_wait; ///< estimated total time spent in condition::wait()
+	};
+
+	lock_profiler() = delete;
+
+	    /// start recording the contention of mutex and condition objects
+
+	    /// \param[in] sampling one contention out of 'sampling' is timed, must not be zero
+	    /// \note contentions that occurred before are not recorded
+	static void enable(unsigned int sampling = 1);
+
+	    /// stop recording contention, the recorded statistics are kept
+	static void disable();
+
+	    /// whether contention is being recorded
+	static bool is_enabled() { return get_sampling() != 0; };
+
+	    /// the sampling given to enable(), zero when disabled
+	static unsigned int get_sampling() { return sampling.load(std::memory_order_relaxed); };
+
+	    /// the most contended objects first
+
+	    /// \param[in] top maximum number of entries to return, zero for all
+	    /// \return objects sorted by decreasing estimated time spent waiting for their lock
+	static std::vector<entry> report(unsigned int top = 0);
+
+	    /// zero all the statistics and forget the destroyed objects
+	static void reset();
+
+	    /// \cond INTERNAL
+	struct record;
+	    /// \endcond
+
+    private:
+	static std::atomic<unsigned int> sampling;  ///< zero when disabled
+
+	static bool take_sample();
+	static record *get_record(std::atomic<record *> & slot, const void *obj);
+	static void set_label(std::atomic<record *> & slot, const void *obj, const std::string & label);
+	static std::string get_label(const std::atomic<record *> & slot, const void *obj);
+	static void retire(std::atomic<record *> & slot);
+	static void contended(std::atomic<record *> & slot, const void *obj, bool sampled, std::chrono::nanoseconds waited);
+	static void waited(std::atomic<record *> & slot, const void *obj, bool sampled, std::chrono::nanoseconds waited);
+
+	friend class mutex;
+	friend class condition;
+    };
+
+} // end of namespace
+
+#endif
@@ -0,0 +1,165 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+
+    // libthreadar headers
+#include "exceptions.hpp"
+#include "tools.hpp"
+
+    // this module's header
+#include "mcs_mutex.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+	// each node on its own cache line so a waiting
+	// thread does not share the line it polls
+
+    struct alignas(64) mcs_mutex::node
+    {
+	atomic<node *> next;   ///< thread queued after this one
+	atomic<bool> waiting;  ///< cleared by the previous thread when it unlocks
+    };
+
+    struct mcs_mutex::node_pool
+    {
+	node slots[max_held];
+	unsigned int free_mask;  ///< bit i set when slots[i] is not used
+
+	node_pool() { free_mask = (1u << max_held) - 1; };
+    };
+
+    static_assert(mcs_mutex::max_held < sizeof(unsigned int)*8, "free_mask too small for max_held");
+
+    void mcs_mutex::lock()
+    {
+	node *me = acquire_node();
+	node *prev;
+
+	me->next.store(nullptr, memory_order_relaxed);
+	me->waiting.store(true, memory_order_relaxed);
+
+	prev = tail.exchange(me, memory_order_acq_rel);
+	if(prev != nullptr)
+	{
+	    unsigned int round = 0;
+
+	    prev->next.store(me, memory_order_release);
+	    while(me->waiting.load(memory_order_acquire))
+		tools_spin_pause(round);
+	}
+
+	owner = me;
+    }
+
+    void mcs_mutex::unlock()
+    {
+	node *me = owner;
+	node *succ = me->next.load(memory_order_acquire);
+
+	if(succ == nullptr)
+	{
+	    node *expected = me;
+	    unsigned int round = 0;
+
+	    if(tail.compare_exchange_strong(expected, nullptr, memory_order_release, memory_order_relaxed))
+	    {
+		release_node(me);
+		return; // no thread was waiting
+	    }
+
+		// a thread has queued itself but has not yet linked
+		// its node to ours
+	    while((succ = me->next.load(memory_order_acquire)) == nullptr)
+		tools_spin_pause(round);
+	}
+
+	succ->waiting.store(false, memory_order_release);
+	release_node(me);
+    }
+
+    bool mcs_mutex::try_lock()
+    {
+	node *me = acquire_node();
+	node *expected = nullptr;
+
+	me->next.store(nullptr, memory_order_relaxed);
+	me->waiting.store(false, memory_order_relaxed);
+
+	if(tail.compare_exchange_strong(expected, me, memory_order_acq_rel, memory_order_relaxed))
+	{
+	    owner = me;
+	    return true;
+	}
+	else
+	{
+	    release_node(me);
+	    return false;
+	}
+    }
+
+    mcs_mutex::node *mcs_mutex::acquire_node()
+    {
+	node_pool & pool = local_pool();
+
+	for(unsigned int i = 0; i < max_held; ++i)
+	{
+	    if((pool.free_mask & (1u << i)) != 0)
+	    {
+		pool.free_mask &= ~(1u << i);
+		return &(pool.slots[i]);
+	    }
+	}
+
+	throw exception_range("too many mcs_mutex held by the same thread");
+    }
+
+    void mcs_mutex::release_node(node *ptr)
+    {
+	node_pool & pool = local_pool();
+	unsigned int index = ptr - pool.slots;
+
+	if(index >= max_held)
+	    throw THREADAR_BUG; // unlock() called from another thread than lock()
+
+	pool.free_mask |= 1u << index;
+    }
+
+    mcs_mutex::node_pool & mcs_mutex::local_pool()
+    {
+	static thread_local node_pool pool;
+
+	return pool;
+    }
+
+} // end of namespace
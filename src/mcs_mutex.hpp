@@ -0,0 +1,113 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_MCS_MUTEX_HPP
+#define LIBTHREADAR_MCS_MUTEX_HPP
+
+    /// \file mcs_mutex.hpp
+    /// \brief defines the mcs_mutex class, a queue based spin lock
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+
+    // libthreadar headers
+
+namespace libthreadar
+{
+
+	/// Class mcs_mutex is a fair spin lock where each waiting thread polls its own cache line
+
+	/// It has the same lock(), unlock() and try_lock() methods as libthreadar::mutex.
+	/// This is the lock of Mellor-Crummey and Scott: threads calling lock() while the mutex is
+	/// held are queued in FIFO order, each one busy waiting on a flag of its own queue node,
+	/// that the thread before it in the queue clears when unlocking. Under high contention,
+	/// unlocking thus only touches the cache line of the next thread, at the difference of
+	/// spin_mutex and ticket_mutex where all waiting threads poll the same cache line.
+	///
+	/// The queue nodes are taken from a small per thread set, a thread can hold
+	/// at most max_held mcs_mutex at the same time.
+	///
+	/// \note unlock() must be called by the thread that locked the mutex
+	/// \note there is no error checking: unlocking a mcs_mutex not locked or locking it twice
+	/// from the same thread is undefined behavior
+	/// \note as the lock is granted in order, a thread preempted while waiting delays all threads
+	/// waiting behind it, mcs_mutex should thus not be used with more threads than CPUs
+    class mcs_mutex
+    {
+    public:
+	    /// maximum number of mcs_mutex a thread can hold at the same time
+	static const unsigned int max_held = 16;
+
+	    /// constructor
+	mcs_mutex(): tail(nullptr), owner(nullptr) {};
+
+	    /// no copy constructor
+	mcs_mutex(const mcs_mutex & ref) = delete;
+
+	    /// no move constructor
+	mcs_mutex(mcs_mutex && ref) = delete;
+
+	    /// no assignment operator
+	mcs_mutex & operator = (const mcs_mutex & ref) = delete;
+
+	    /// no move operator
+	mcs_mutex & operator = (mcs_mutex && ref) = delete;
+
+	    /// destructor
+	~mcs_mutex() = default;
+
+	    /// lock the mutex, busy waiting for the threads that called lock() before
+
+	    /// \note throws exception_range if the calling thread already holds max_held mcs_mutex
+	void lock();
+
+	    /// unlock the mutex, granting it to the next thread in order
+	void unlock();
+
+	    /// acquire the mutex if available without waiting
+
+	    /// \return true if lock is acquired false if mutex was already locked
+	bool try_lock();
+
+    private:
+	struct node;
+	struct node_pool;
+
+	std::atomic<node *> tail;   ///< last thread of the queue, nullptr if the mutex is available
+	node *owner;                ///< node of the thread holding the mutex
+
+	static node *acquire_node();
+	static void release_node(node *ptr);
+	static node_pool & local_pool();
+    };
+
+} // end of namespace
+
+#endif
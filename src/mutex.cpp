@@ -31,7 +31,7 @@ extern "C"
 #endif
 }
     // C++ standard headers
-
+#include <chrono>
 
     // libthreadar headers
 
@@ -43,7 +43,7 @@ using namespace std;
 namespace libthreadar
 {
 
-    mutex::mutex()
+    mutex::mutex(): prof(nullptr)
     {
 	int ret = pthread_mutex_init(&mut, NULL);
 	if(ret != 0)
@@ -55,10 +55,17 @@ namespace libthreadar
 	try_lock();
 	unlock();  // we possibly unlock the mutex locked from another thread
 	(void)pthread_mutex_destroy(&mut);
+	lock_profiler::retire(prof);
     }
 
     void mutex::lock()
     {
+	if(lock_profiler::sampling.load(memory_order_relaxed) != 0)
+	{
+	    profiled_lock();
+	    return;
+	}
+
 	switch(pthread_mutex_lock(&mut))
 	{
 	case 0:
@@ -90,5 +97,39 @@ namespace libthreadar
 	return ret == 0;
     }
 
+    void mutex::profiled_lock()
+    {
+	bool sampled;
+	chrono::steady_clock::time_point start;
+	int ret = pthread_mutex_trylock(&mut);
+
+	if(ret == 0)
+	    return;
+	if(ret != EBUSY)
+	    throw string("Error while trying locking mutex");
+
+	    // the mutex is held by another thread
+
+	sampled = lock_profiler::take_sample();
+	if(sampled)
+	    start = chrono::steady_clock::now();
+
+	if(pthread_mutex_lock(&mut) != 0)
+	    throw string("BUG");
+
+	try
+	{
+	    lock_profiler::contended(prof,
+				     this,
+				     sampled,
+				     sampled ? chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start) : chrono::nanoseconds(0));
+	}
+	catch(...)
+	{
+	    (void)pthread_mutex_unlock(&mut);
+	    throw;
+	}
+    }
+
 } // end of namespace
 
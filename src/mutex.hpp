@@ -39,9 +39,11 @@ extern "C"
 }
     // C++ standard headers
 #include <string>
+#include <atomic>
 
 
     // libthreadar headers
+#include "lock_profiler.hpp"
 
 
 namespace libthreadar
@@ -53,6 +55,9 @@ namespace libthreadar
 	/// after accessing that data.
 	/// If another thread is already accessing that data calling lock() will
 	/// suspended the calling thread up to the time the thread accessing the data calls unlock()
+	/// \note the contention of mutex objects can be measured with lock_profiler
+	/// \note see also futex_mutex for a lighter alternative, and spin_mutex, ticket_mutex
+	/// and mcs_mutex for very short critical sections
     class mutex
     {
     public:
@@ -63,13 +68,13 @@ namespace libthreadar
 	mutex(const mutex & ref) = delete;
 
 	    /// no move constructor
-	mutex(mutex && ref) = default;
+	mutex(mutex && ref) = delete;
 
 	    /// no assignment operator
 	mutex & operator = (const mutex & ref) = delete;
 
 	    /// no move operator
-	mutex & operator = (mutex && ref) noexcept = default;
+	mutex & operator = (mutex && ref) = delete;
 
 	    /// destructor
 	virtual ~mutex();
@@ -92,8 +97,18 @@ namespace libthreadar
 	    /// \return true if lock is acquired false if mutex was already locked
 	bool try_lock();
 
+	    /// give a label to the mutex to identify it in lock_profiler::report()
+	void set_label(const std::string & label) { lock_profiler::set_label(prof, this, label); };
+
+	    /// the label of the mutex, its address if no label has been given
+	std::string get_label() const { return lock_profiler::get_label(prof, this); };
+
     protected:
 	pthread_mutex_t mut; //< the mutex
+	std::atomic<lock_profiler::record *> prof; //< contention statistics, created at first contention while profiling
+
+    private:
+	void profiled_lock();
     };
 
 } // end of namespace
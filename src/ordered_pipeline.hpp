@@ -0,0 +1,413 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef LIBTHREADAR_ORDERED_PIPELINE_HPP
+#define LIBTHREADAR_ORDERED_PIPELINE_HPP
+
+    /// \file ordered_pipeline.hpp
+    /// \brief defines the ordered_pipeline class that runs a transform over a set of workers keeping data order
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <deque>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <exception>
+
+    // libthreadar headers
+#include "exceptions.hpp"
+#include "condition.hpp"
+#include "thread.hpp"
+#include "ratelier_scatter.hpp"
+#include "ratelier_gather.hpp"
+
+namespace libthreadar
+{
+
+	/// Class ordered_pipeline transforms an ordered flow of objects using a set of worker threads
+
+	/// This class implements the scatter/workers/gather pattern described in the ratelier_gather
+	/// documentation: it owns a ratelier_scatter, a ratelier_gather and the worker threads in between.
+	/// A first thread (the *feeder*) provides objects of type In calling feed(), each worker applies
+	/// the transform function given at construction time and a second thread (the *gatherer*) obtains
+	/// the resulting objects of type Out calling gather(), in the exact order they have been fed,
+	/// whatever the order the workers completed their task.
+	///
+	/// Once all data has been fed, the feeder calls finish(). The gatherer then receives all pending
+	/// results and gather() returns false to signal the end of the stream, at which time all
+	/// worker threads have been joined.
+	///
+	/// If the transform function throws an exception, the gatherer receives the results that precede
+	/// the failed object, then the pipeline is aborted: pending data is dropped, the worker threads are
+	/// stopped and joined, and the exception is propagated from gather() by mean of thread::join().
+	/// Further calls to feed() or finish() throw an exception_thread.
+	///
+	/// \note the capacity of both rateliers is derived from the number of workers, for
+	/// the workers not to stay pending for a free slot while the feeder or the gatherer are still active.
+	/// \note end of stream, flush and error notifications travel through the rateliers as control
+	/// messages, they do not require any object to be allocated
+
+    template <class In, class Out> class ordered_pipeline
+    {
+    public:
+	    /// the type of the function workers apply to each object
+
+	    /// \note the function receives the object as fed by the feeder and must return a non null
+	    /// object to be provided to the gatherer. It is called concurrently by the different workers.
+	typedef std::function<std::unique_ptr<Out>(std::unique_ptr<In> &)> transform;
+
+	    /// constructor
+
+	    /// \param[in] num_workers number of worker threads to run, must be at least one
+	    /// \param[in] fn the transform function to apply by workers on each object
+	    /// \note the worker threads are launched by the constructor
+	ordered_pipeline(unsigned int num_workers, transform fn);
+
+	    /// no copy constructor
+	ordered_pipeline(const ordered_pipeline & ref) = delete;
+
+	    /// no move constructor (workers refer to the object)
+	ordered_pipeline(ordered_pipeline && ref) = delete;
+
+	    /// no assignment operator
+	ordered_pipeline & operator = (const ordered_pipeline & ref) = delete;
+
+	    /// no move operator
+	ordered_pipeline & operator = (ordered_pipeline && ref) = delete;
+
+	    /// destructor
+
+	    /// \note if the stream has not been fully gathered, the pipeline is aborted, pending data
+	    /// is dropped and exception that could have been thrown by workers are ignored
+	    /// \note the feeder thread must have been joined before, as it may stay suspended in feed()
+	    /// once the gatherer stops gathering
+	~ordered_pipeline();
+
+	    /// feeder call: provides a new object to transform
+
+	    /// \param[in,out] one the object to transform, it is moved into the pipeline
+	    /// \note the caller may be suspended if the pipeline is full
+	void feed(std::unique_ptr<In> & one);
+
+	    /// feeder call: signals that no more data will be fed
+	void finish();
+
+	    /// feeder call: wait for all objects fed so far to have been gathered
+
+	    /// \note the caller is suspended until the gatherer obtained, calling gather(),
+	    /// the results of all objects fed before this call
+	void flush();
+
+	    /// gatherer call: obtain the next transformed objects in order
+
+	    /// \param[out] ones the next continuously indexed objects, which may be empty when false is returned
+	    /// \return false once the end of stream has been reached, all workers having been joined at that time
+	    /// \note the caller is suspended until at least one object is available or the end of stream is met
+	bool gather(std::deque<std::unique_ptr<Out> > & ones);
+
+	    /// the number of worker threads
+	unsigned int get_num_workers() const { return workers.size(); };
+
+	    /// the number of slots of each ratelier
+	unsigned int get_capacity() const { return capacity; };
+
+	    /// statistics of the ratelier dispatching objects to workers
+	typename ratelier_scatter<In>::statistics get_scatter_statistics() const { return scat.get_statistics(); };
+
+	    /// statistics of the ratelier reordering the transformed objects
+	typename ratelier_gather<Out>::statistics get_gather_statistics() const { return gath.get_statistics(); };
+
+    private:
+	static const signed int flag_data = 0; ///< flag of regular objects
+	static const signed int flag_eof = 1;  ///< flag of end of stream notifications
+	static const signed int flag_flush = 2; ///< flag of flush requests
+	    // negative flags (-1 - worker index) are error notifications from the given worker
+
+	class worker : public thread
+	{
+	public:
+	    worker(ordered_pipeline & owner, unsigned int index): pipe(owner), num(index) {};
+	    worker(const worker & ref) = delete;
+	    worker & operator = (const worker & ref) = delete;
+	    ~worker() { try { cancel(); join(); } catch(...) {} };
+
+	protected:
+	    virtual void inherited_run() override { pipe.work(num); };
+
+	private:
+	    ordered_pipeline & pipe;
+	    unsigned int num;
+	};
+
+	unsigned int capacity;                  ///< number of slots of each ratelier
+	transform func;                         ///< the transform to apply on each object
+	ratelier_scatter<In> scat;              ///< dispatches fed objects to workers
+	ratelier_gather<Out> gath;              ///< collects transformed objects in order
+	std::deque<std::unique_ptr<worker> > workers; ///< the worker threads
+	std::atomic<bool> broken;               ///< whether the pipeline has been aborted
+	bool finished;                          ///< whether finish() has been called
+	bool joined;                            ///< whether the workers have been joined
+	bool failed;                            ///< whether gather() met an error notification
+
+	void work(unsigned int index);
+	void abort();
+	void join_workers();
+
+	static unsigned int capacity_for(unsigned int num_workers) { return num_workers < 1 ? 2 : 2 * num_workers; };
+    };
+
+    template <class In, class Out> ordered_pipeline<In, Out>::ordered_pipeline(unsigned int num_workers, transform fn):
+	capacity(capacity_for(num_workers)),
+	func(fn),
+	scat(capacity, 0, num_workers),
+	gath(capacity),
+	broken(false)
+    {
+	finished = false;
+	joined = false;
+	failed = false;
+
+	if(num_workers < 1)
+	    throw exception_range("ordered_pipeline needs at least one worker");
+	if(! func)
+	    throw exception_range("ordered_pipeline needs a transform function");
+
+	try
+	{
+	    for(unsigned int i = 0; i < num_workers; ++i)
+	    {
+		workers.push_back(std::unique_ptr<worker>(new (std::nothrow) worker(*this, i)));
+		if(! workers.back())
+		    throw exception_memory();
+		workers.back()->run();
+	    }
+	}
+	catch(...)
+	{
+	    try
+	    {
+		abort();
+	    }
+	    catch(...)
+	    {
+		    // ignoring workers exceptions, they should not have run any transform
+	    }
+	    throw;
+	}
+    }
+
+    template <class In, class Out> ordered_pipeline<In, Out>::~ordered_pipeline()
+    {
+	try
+	{
+	    abort();
+	}
+	catch(...)
+	{
+		// a destructor should not generate exceptions
+	}
+    }
+
+    template <class In, class Out> void ordered_pipeline<In, Out>::feed(std::unique_ptr<In> & one)
+    {
+	if(broken)
+	    throw exception_thread("ordered_pipeline has been aborted");
+	if(finished)
+	    throw exception_range("cannot feed an ordered_pipeline after finish() has been called");
+	if(! one)
+	    throw exception_range("cannot feed an ordered_pipeline with a null object");
+
+	scat.scatter(one, flag_data);
+    }
+
+    template <class In, class Out> void ordered_pipeline<In, Out>::finish()
+    {
+	if(broken)
+	    throw exception_thread("ordered_pipeline has been aborted");
+	if(finished)
+	    throw exception_range("finish() called twice on an ordered_pipeline");
+
+	finished = true;
+	(void)scat.broadcast_flag(flag_eof);
+    }
+
+    template <class In, class Out> void ordered_pipeline<In, Out>::flush()
+    {
+	if(broken)
+	    throw exception_thread("ordered_pipeline has been aborted");
+	if(finished)
+	    throw exception_range("cannot flush an ordered_pipeline after finish() has been called");
+
+	gath.wait_gathered(scat.scatter_flag(flag_flush));
+
+	if(broken)
+	    throw exception_thread("ordered_pipeline has been aborted");
+    }
+
+    template <class In, class Out> bool ordered_pipeline<In, Out>::gather(std::deque<std::unique_ptr<Out> > & ones)
+    {
+	std::deque<std::unique_ptr<Out> > tmp;
+	std::deque<signed int> flags;
+
+	ones.clear();
+	if(joined)
+	    return false;
+
+	if(failed)
+	{
+	    abort();
+	    throw THREADAR_BUG;
+	}
+
+	gath.gather(tmp, flags);
+	if(tmp.size() != flags.size())
+	    throw THREADAR_BUG;
+
+	for(unsigned int i = 0; i < tmp.size(); ++i)
+	{
+	    if(flags[i] == flag_data)
+		ones.push_back(std::move(tmp[i]));
+	    else if(flags[i] == flag_flush)
+		continue; // the flush() caller has been released by the gathering
+	    else if(flags[i] == flag_eof)
+	    {
+		    // all data preceeding the end of stream has been gathered
+		    // and workers are all ending
+		join_workers();
+		return false;
+	    }
+	    else if(flags[i] < 0)
+	    {
+		    // a worker failed, abort() propagates the exception
+		    // once the worker has been joined, but we first
+		    // deliver the objects that preceeded the failure
+		failed = true;
+		if(! ones.empty())
+		    return true;
+		abort();
+		throw THREADAR_BUG;
+	    }
+	    else
+		throw THREADAR_BUG;
+	}
+
+	return true;
+    }
+
+    template <class In, class Out> void ordered_pipeline<In, Out>::work(unsigned int index)
+    {
+	unsigned int slot;
+	signed int flag;
+
+	while(true)
+	{
+	    std::unique_ptr<In> in = scat.worker_get_one(slot, flag, index);
+
+	    if(flag == flag_eof)
+	    {
+		if(! broken)
+		    gath.worker_push_flag(slot, flag_eof);
+		return;
+	    }
+
+	    if(broken)
+		continue; // dropping pending data up to our end of stream notification
+
+	    if(flag == flag_flush)
+	    {
+		gath.worker_push_flag(slot, flag_flush);
+		continue;
+	    }
+
+	    std::unique_ptr<Out> out;
+
+	    try
+	    {
+		out = func(in);
+		if(! out)
+		    throw exception_range("ordered_pipeline transform function returned a null object");
+	    }
+	    catch(...)
+	    {
+		if(! broken) // letting the gatherer know it will not receive this slot
+		    gath.worker_push_flag(slot, -1 - (signed int)index);
+		throw; // the exception will be propagated by thread::join()
+	    }
+
+	    if(! broken)
+		gath.worker_push_one(slot, out, flag_data);
+	}
+    }
+
+    template <class In, class Out> void ordered_pipeline<In, Out>::abort()
+    {
+	if(joined)
+	    return;
+
+	broken = true;
+
+	    // releasing workers possibly suspended on a full ratelier_gather
+	    // as well as a possible flush() caller, and dropping data not yet
+	    // fetched by workers
+	gath.reset();
+	scat.reset();
+
+	    // having each worker still alive exit its loop, the notifications
+	    // of workers that already ended stay in the ratelier_scatter
+	(void)scat.broadcast_flag(flag_eof);
+
+	join_workers();
+    }
+
+    template <class In, class Out> void ordered_pipeline<In, Out>::join_workers()
+    {
+	std::exception_ptr first;
+
+	joined = true;
+	for(unsigned int i = 0; i < workers.size(); ++i)
+	{
+	    try
+	    {
+		if(workers[i])
+		    workers[i]->join();
+	    }
+	    catch(...)
+	    {
+		if(! first)
+		    first = std::current_exception();
+	    }
+	}
+
+	if(first)
+	    std::rethrow_exception(first);
+    }
+
+} // end of namespace
+
+#endif
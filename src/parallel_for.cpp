@@ -0,0 +1,63 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+}
+    // C++ standard headers
+
+    // libthreadar headers
+
+    // this module's header
+#include "parallel_for.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+    static unsigned int default_pool_size()
+    {
+	long cpus = 1;
+
+#if HAVE_UNISTD_H
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	    // the calling thread takes part to the work
+	return cpus > 2 ? (unsigned int)(cpus - 1) : 1;
+    }
+
+    thread_pool & parallel_default_pool()
+    {
+	static thread_pool pool(default_pool_size());
+
+	return pool;
+    }
+
+} // end of namespace
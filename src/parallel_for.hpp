@@ -0,0 +1,259 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef LIBTHREADAR_PARALLEL_FOR_HPP
+#define LIBTHREADAR_PARALLEL_FOR_HPP
+
+    /// \file parallel_for.hpp
+    /// \brief defines the parallel_for() and parallel_reduce() functions that split a loop over a thread_pool
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <exception>
+
+    // libthreadar headers
+#include "exceptions.hpp"
+#include "thread_pool.hpp"
+
+namespace libthreadar
+{
+
+	/// the thread_pool used by parallel_for() and parallel_reduce() when none is given
+
+	/// this pool is created at first use with one worker less than the number of online CPUs
+	/// (but at least one), as the calling thread takes part to the work.
+    extern thread_pool & parallel_default_pool();
+
+	/// run a loop over a range of indexes in parallel
+
+	/// The range [first, last) is recursively split in two halves until the size of the
+	/// sub-ranges is not greater than grain. At each split, the upper half is submitted to the
+	/// pool while the caller goes on splitting the lower half, then runs the lowest sub-range
+	/// itself. The caller then runs itself the upper halves no worker has started yet and waits
+	/// for the others, thus waiting never blocks a worker on a task that is not running.
+	///
+	/// \param[in] pool the thread_pool whose workers run the sub-ranges
+	/// \param[in] first first index of the range
+	/// \param[in] last index following the last index of the range
+	/// \param[in] grain maximum size of a sub-range given to fn, zero for automatic choice
+	/// \param[in] fn callable object invoked as fn(begin, end) on each sub-range [begin, end)
+	/// \note if fn throws an exception, the sub-ranges not yet started are skipped, and the
+	/// first exception is rethrown once all started sub-ranges have completed
+	/// \note fn is called concurrently from different threads
+    template <class Index, class F> void parallel_for(thread_pool & pool, Index first, Index last, Index grain, F fn);
+
+	/// same as the previous parallel_for() using the parallel_default_pool()
+    template <class Index, class F> void parallel_for(Index first, Index last, Index grain, F fn)
+    {
+	parallel_for(parallel_default_pool(), first, last, grain, fn);
+    }
+
+	/// compute in parallel a reduction over a range of indexes
+
+	/// The range is split as done by parallel_for(). Each sub-range [begin, end) gives a partial
+	/// result fn(begin, end, identity), the partial results are then combined in the order of the
+	/// sub-ranges, thus combine does need to be associative but not commutative.
+	///
+	/// \param[in] pool the thread_pool whose workers run the sub-ranges
+	/// \param[in] first first index of the range
+	/// \param[in] last index following the last index of the range
+	/// \param[in] grain maximum size of a sub-range given to fn, zero for automatic choice
+	/// \param[in] identity neutral element of combine, returned for an empty range
+	/// \param[in] fn callable object invoked as fn(begin, end, identity) returning a T
+	/// \param[in] combine callable object invoked as combine(a, b) returning a T
+	/// \return the combination of all the partial results
+    template <class Index, class T, class F, class C> T parallel_reduce(thread_pool & pool,
+									 Index first,
+									 Index last,
+									 Index grain,
+									 const T & identity,
+									 F fn,
+									 C combine);
+
+	/// same as the previous parallel_reduce() using the parallel_default_pool()
+    template <class Index, class T, class F, class C> T parallel_reduce(Index first,
+									 Index last,
+									 Index grain,
+									 const T & identity,
+									 F fn,
+									 C combine)
+    {
+	return parallel_reduce(parallel_default_pool(), first, last, grain, identity, fn, combine);
+    }
+
+
+	/// \cond INTERNAL
+
+	/// the range splitting shared by parallel_for() and parallel_reduce()
+
+    template <class Index, class T, class F, class C> class parallel_splitter
+    {
+    public:
+	parallel_splitter(thread_pool & p, Index g, const T & id, F & f, C & c):
+	    pool(p), grain(g), identity(id), fn(f), combine(c) {};
+
+	    /// compute the range [first, last), helped by the pool's workers
+	T run(Index first, Index last)
+	{
+	    std::vector<std::shared_ptr<part> > uppers;
+	    std::exception_ptr except;
+	    T ret = identity;
+
+	    try
+	    {
+		while(last - first > grain)
+		{
+		    Index middle = first + (last - first) / 2;
+		    std::shared_ptr<part> upper(new (std::nothrow) part(middle, last));
+
+		    if(! upper)
+			throw exception_memory();
+
+		    upper->task = pool.submit([this, upper]()
+					      {
+						  if(! upper->claimed.exchange(true))
+						      upper->value.reset(new T(run(upper->first, upper->last)));
+					      });
+		    uppers.push_back(upper);
+		    last = middle;
+		}
+
+		ret = fn(first, last, identity);
+	    }
+	    catch(...)
+	    {
+		except = std::current_exception();
+	    }
+
+		// upper parts from the lowest to the highest
+
+	    for(typename std::vector<std::shared_ptr<part> >::reverse_iterator it = uppers.rbegin();
+		it != uppers.rend();
+		++it)
+	    {
+		try
+		{
+		    if(! (*it)->claimed.exchange(true))
+		    {
+			    // not started by any worker, running it ourself
+			    // unless an error occurred
+			if(! except)
+			    ret = combine(ret, run((*it)->first, (*it)->last));
+		    }
+		    else
+		    {
+			(*it)->task.wait();
+			if(! except)
+			{
+			    if(! (*it)->value)
+				throw THREADAR_BUG;
+			    ret = combine(ret, *((*it)->value));
+			}
+		    }
+		}
+		catch(...)
+		{
+		    if(! except)
+			except = std::current_exception();
+		}
+	    }
+
+	    if(except)
+		std::rethrow_exception(except);
+
+	    return ret;
+	};
+
+    private:
+	struct part
+	{
+	    Index first;
+	    Index last;
+	    std::atomic<bool> claimed;    ///< set by the first thread to run the part, worker or splitter
+	    thread_pool::handle task;     ///< task submitted to the pool for this part
+	    std::unique_ptr<T> value;     ///< result when computed by a worker
+
+	    part(Index f, Index l): first(f), last(l), claimed(false) {};
+	};
+
+	thread_pool & pool;
+	Index grain;
+	const T & identity;
+	F & fn;
+	C & combine;
+    };
+
+    template <class Index> Index parallel_auto_grain(thread_pool & pool, Index first, Index last)
+    {
+	    // about eight sub-ranges per thread for load balancing
+	Index ret = (last - first) / (Index(pool.get_max_workers() + 1) * 8);
+
+	return ret < 1 ? 1 : ret;
+    }
+
+	/// \endcond
+
+    template <class Index, class F> void parallel_for(thread_pool & pool, Index first, Index last, Index grain, F fn)
+    {
+	struct none {};
+	none id;
+	auto leaf = [&fn](Index begin, Index end, const none & x) -> none { fn(begin, end); return x; };
+	auto comb = [](const none & a, const none &) -> none { return a; };
+
+	if(last <= first)
+	    return;
+	if(grain < 1)
+	    grain = parallel_auto_grain(pool, first, last);
+
+	parallel_splitter<Index, none, decltype(leaf), decltype(comb)> split(pool, grain, id, leaf, comb);
+	(void)split.run(first, last);
+    }
+
+    template <class Index, class T, class F, class C> T parallel_reduce(thread_pool & pool,
+									 Index first,
+									 Index last,
+									 Index grain,
+									 const T & identity,
+									 F fn,
+									 C combine)
+    {
+	if(last <= first)
+	    return identity;
+	if(grain < 1)
+	    grain = parallel_auto_grain(pool, first, last);
+
+	parallel_splitter<Index, T, F, C> split(pool, grain, identity, fn, combine);
+	return split.run(first, last);
+    }
+
+} // end of namespace
+
+#endif
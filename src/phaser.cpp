@@ -0,0 +1,154 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+
+    // libthreadar headers
+#include "lock_guard.hpp"
+
+    // this module's header
+#include "phaser.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+    phaser::phaser(unsigned int num): parties(num), arrived(0), phase(0), verrou(1)
+    {
+    }
+
+    unsigned int phaser::register_party(unsigned int n)
+    {
+	lock_guard<condition> guard(verrou);
+
+	if(parties + n < parties)
+	    throw exception_range("too many parties registered to phaser");
+	parties += n;
+
+	return phase;
+    }
+
+    unsigned int phaser::arrive()
+    {
+	lock_guard<condition> guard(verrou);
+	unsigned int ret = phase;
+
+	arrive_locked();
+
+	return ret;
+    }
+
+    unsigned int phaser::arrive_and_deregister()
+    {
+	lock_guard<condition> guard(verrou);
+	unsigned int ret = phase;
+
+	if(arrived >= parties)
+	    throw exception_range("no registered party left to deregister from phaser");
+
+	--parties;
+	check_advance();
+
+	return ret;
+    }
+
+    unsigned int phaser::get_phase() const
+    {
+	lock_guard<condition> guard(verrou);
+
+	return phase;
+    }
+
+    unsigned int phaser::get_registered() const
+    {
+	lock_guard<condition> guard(verrou);
+
+	return parties;
+    }
+
+    unsigned int phaser::get_arrived() const
+    {
+	lock_guard<condition> guard(verrou);
+
+	return arrived;
+    }
+
+    void phaser::arrive_locked()
+    {
+	    // must be called with verrou acquired
+
+	if(arrived >= parties)
+	    throw exception_range("more arrivals than registered parties on phaser");
+
+	++arrived;
+	check_advance();
+    }
+
+    void phaser::check_advance()
+    {
+	    // must be called with verrou acquired
+
+	if(arrived == parties)
+	{
+	    arrived = 0;
+	    ++phase;
+	    if(verrou.get_waiting_thread_count() > 0)
+		verrou.broadcast();
+	}
+    }
+
+    unsigned int phaser::arrive_and_wait_with(const cancellation_token *token)
+    {
+	lock_guard<condition> guard(verrou);
+	unsigned int current = phase;
+
+	arrive_locked();
+	if(token != nullptr)
+	    verrou.wait(0, [this, current]() { return phase != current; }, *token);
+	else
+	    verrou.wait(0, [this, current]() { return phase != current; });
+
+	return phase;
+    }
+
+    unsigned int phaser::await_advance_with(unsigned int phase_num, const cancellation_token *token)
+    {
+	lock_guard<condition> guard(verrou);
+
+	if(token != nullptr)
+	    verrou.wait(0, [this, phase_num]() { return phase != phase_num; }, *token);
+	else
+	    verrou.wait(0, [this, phase_num]() { return phase != phase_num; });
+
+	return phase;
+    }
+
+} // end of namespace
@@ -0,0 +1,146 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_PHASER_HPP
+#define LIBTHREADAR_PHASER_HPP
+
+    /// \file phaser.hpp
+    /// \brief defines the phaser class, a reusable barrier which parties can join and leave
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+
+    // libthreadar headers
+#include "exceptions.hpp"
+#include "condition.hpp"
+
+namespace libthreadar
+{
+
+	/// Class phaser is a barrier which number of parties can change at runtime
+
+	/// The phaser synchronizes its registered parties phase after phase: a phase completes
+	/// when all registered parties have arrived, the phase number is then incremented and
+	/// the threads waiting for that phase to complete are released.
+	///
+	/// A party registers with register_party(), even while the other parties are in the middle
+	/// of a phase, in which case it takes part to the current phase. It leaves with arrive_and_deregister(),
+	/// which counts as its arrival for the current phase and removes it from the next ones. A pool
+	/// which number of workers varies can thus keep synchronizing them without recreating a barrier.
+	///
+	/// Arriving and waiting are separated operations: arrive() does not suspend the caller,
+	/// await_advance() waits for a given phase to complete, and arrive_and_wait() does both
+	/// like barrier::wait().
+	///
+	/// \note phase numbers wrap around after UINT_MAX phases
+	/// \note await_advance() and arrive_and_wait() are cancellation points for libthreadar threads
+	/// like condition::wait(), a cancelled thread stays counted as arrived for the phase
+    class phaser
+    {
+    public:
+	    /// constructor
+
+	    /// \param[in] num initial number of registered parties
+	phaser(unsigned int num = 0);
+
+	    /// no copy constructor
+	phaser(const phaser & ref) = delete;
+
+	    /// no move constructor
+	phaser(phaser && ref) = delete;
+
+	    /// no assignment operator
+	phaser & operator = (const phaser & ref) = delete;
+
+	    /// no move operator
+	phaser & operator = (phaser && ref) = delete;
+
+	    /// destructor
+
+	    /// \note the object must not be destroyed while threads are waiting on it
+	~phaser() = default;
+
+	    /// add parties to the current phase
+
+	    /// \param[in] n number of parties to register
+	    /// \return the current phase number, the first one the new parties take part to
+	unsigned int register_party(unsigned int n = 1);
+
+	    /// signal the arrival of a party without waiting for the others
+
+	    /// \return the number of the phase the caller arrived at
+	    /// \note throws exception_range if all registered parties have already arrived
+	unsigned int arrive();
+
+	    /// signal the arrival of a party and remove it from the next phases
+
+	    /// \return the number of the phase the caller arrived at
+	unsigned int arrive_and_deregister();
+
+	    /// signal the arrival of a party and wait for the others
+
+	    /// \return the number of the new phase
+	unsigned int arrive_and_wait() { return arrive_and_wait_with(nullptr); };
+
+	    /// same as arrive_and_wait() also awaken when the given token is cancelled
+	unsigned int arrive_and_wait(const cancellation_token & token) { return arrive_and_wait_with(&token); };
+
+	    /// wait for the given phase to complete
+
+	    /// \param[in] phase_num number of the phase to wait for, as returned by arrive()
+	    /// \return the number of the new phase, returning immediately if the current phase is not phase_num
+	unsigned int await_advance(unsigned int phase_num) { return await_advance_with(phase_num, nullptr); };
+
+	    /// same as await_advance() also awaken when the given token is cancelled
+	unsigned int await_advance(unsigned int phase_num, const cancellation_token & token) { return await_advance_with(phase_num, &token); };
+
+	    /// the current phase number
+	unsigned int get_phase() const;
+
+	    /// the number of registered parties
+	unsigned int get_registered() const;
+
+	    /// the number of parties arrived at the current phase
+	unsigned int get_arrived() const;
+
+    private:
+	unsigned int parties;     ///< number of registered parties
+	unsigned int arrived;     ///< number of parties arrived at the current phase
+	unsigned int phase;       ///< current phase number
+	mutable condition verrou; ///< protects the fields above, threads wait for the phase to change
+
+	void arrive_locked();
+	void check_advance();
+	unsigned int arrive_and_wait_with(const cancellation_token *token);
+	unsigned int await_advance_with(unsigned int phase_num, const cancellation_token *token);
+    };
+
+} // end of namespace
+
+#endif
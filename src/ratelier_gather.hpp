@@ -38,9 +38,12 @@ extern "C"
 #include <map>
 #include <deque>
 #include <memory>
+#include <chrono>
 
     // libthreadar headers
 #include "mutex.hpp"
+#include "condition.hpp"
+#include "lock_guard.hpp"
 
 
 namespace libthreadar
@@ -95,8 +98,16 @@ namespace libthreadar
 	/// fetches those objects, which are provided in order, this releases the
 	/// corresponding slots of the ratelier_gather object for workers to drop
 	/// next results in it.
+	///
+	/// A worker that received a control message from a ratelier_scatter (see ratelier_scatter::scatter_flag())
+	/// forwards it with worker_push_flag(), the gathering thread then obtains it as an empty std::unique_ptr
+	/// with its associated flag. Another thread can wait for a given index to be gathered with wait_gathered(),
+	/// which combined with ratelier_scatter::scatter_flag() implements a flush operation.
+	///
+	/// The second template argument is the type of the internal lock and conditions, libthreadar::condition
+	/// by default, futex_condition can be used instead to avoid the pthread layer.
 
-    template <class T> class ratelier_gather
+    template <class T, class C = condition> class ratelier_gather
     {
     public:
 	ratelier_gather(unsigned int size, signed int flag = 0);
@@ -116,24 +127,72 @@ namespace libthreadar
 	    /// non-worker gathering thread calls gather() to make some room.
 	void worker_push_one(unsigned int slot, std::unique_ptr<T> & one, signed int flag = 0);
 
+	    /// provides to a worker thread a mean to forward a control message without object to the gathering thread
+
+	    /// \param[in] slot is the slot number associated to the control message
+	    /// \param[in] flag is the signal to send to the gathering thread
+	    /// \note the gathering thread obtains an empty std::unique_ptr for this slot
+	void worker_push_flag(unsigned int slot, signed int flag);
+
 	    /// obtain the lowest continuous filled slots from the ratelier_gather and free them
 
 	    /// \param[out] ones is a list of continuously indexed objects which immediately follows the list
 	    /// provided by a previous call to gather().
 	    /// \param[out] flag is the purpose free signal transmitted by the workers and associated to each object
 	    /// \note the provided arguments, ones and flags, should always have the same size.
+	    /// \note control messages pushed by worker_push_flag() are provided as empty std::unique_ptr
 	void gather(std::deque<std::unique_ptr<T> > & ones, std::deque<signed int> & flag);
 
+	    /// suspend the caller until the given slot has been provided to the gathering thread
+
+	    /// \param[in] slot the slot number to wait for, for example the index returned by ratelier_scatter::scatter_flag()
+	    /// \note the caller is also released if reset() is called meanwhile
+	    /// \note this must not be called by the gathering thread itself
+	void wait_gathered(unsigned int slot);
+
 	    /// reset the object in its prestine state
 
 	    /// this restarts the index to zero. The next index that a worker should give
 	    /// for any data be provided to the gathering thread should be zero.
+	    /// \note statistics are not reset, see reset_statistics()
 	void reset();
 
+	    /// counters maintained by the ratelier_gather to help sizing it
+
+	    /// workers suspended while a slot is free (single_slot_holds) or the gathering thread suspended
+	    /// while some data is pending (head_of_line_waits) show head-of-line blocking: the next index to
+	    /// provide to the gathering thread is late compared to the following ones. The depth histogram
+	    /// shows how much the ratelier is used to reorder the data.
+	struct statistics
+	{
+	    unsigned long long pushed;                    ///< number of entries pushed by workers so far
+	    unsigned long long worker_waits;              ///< number of times a worker was suspended waiting for a slot
+	    std::chrono::nanoseconds worker_wait_time;    ///< cumulated time workers were suspended waiting for a slot
+	    unsigned long long single_slot_holds;         ///< number of these worker suspensions due to the last free slot being kept for the next index
+	    std::chrono::nanoseconds single_slot_hold_time; ///< cumulated time of these suspensions
+	    unsigned long long gather_waits;              ///< number of times the gathering thread was suspended
+	    std::chrono::nanoseconds gather_wait_time;    ///< cumulated time the gathering thread was suspended
+	    unsigned long long head_of_line_waits;        ///< number of gathering thread suspensions while some data was pending but not the next index
+	    std::vector<unsigned long long> depth;        ///< depth[i] is the number of worker_push_one() calls that left i entries in the ratelier
+
+	    statistics(unsigned int size = 0): depth(size + 1, 0)
+	    {
+		pushed = worker_waits = single_slot_holds = gather_waits = head_of_line_waits = 0;
+		worker_wait_time = single_slot_hold_time = gather_wait_time = std::chrono::nanoseconds::zero();
+	    };
+	};
+
+	    /// obtain a snapshot of the statistics
+	statistics get_statistics() const;
+
+	    /// reset the statistics
+	void reset_statistics();
+
     private:
 
 	static const unsigned int cond_pending_data = 0; ///< condition when the object is empty and thread is waiting for situation change
 	static const unsigned int cond_full = 1;         ///< condition when the object is full and thread is waiting for situation change
+	static const unsigned int cond_gathered = 2;     ///< condition when a thread is waiting for a given slot to be gathered
 
 	struct slot
 	{
@@ -147,32 +206,56 @@ namespace libthreadar
 	};
 
 	unsigned int next_index; ///< next index to start the next gather() with
+	unsigned int resets;     ///< number of times reset() has been called (to release wait_gathered() callers)
 	std::vector<slot> table; ///< table of slots to store data
 	std::map<unsigned int, unsigned int> corres; ///< associate infinite range index to index in table
 	std::deque<unsigned int> empty_slot; ///< empty slot of table
-	libthreadar::condition verrou;  ///< lock to manipulate private data
+	mutable C verrou;                       ///< lock to manipulate private data
+	statistics stats;               ///< counters about the ratelier usage
+
+	    /// whether a worker providing the given slot has to wait
+	bool must_wait(unsigned int slot) const
+	{
+	    return empty_slot.empty()  // no free slot available
+		|| ((empty_slot.size() == 1 && slot != next_index) // one slot available and we do not provide the lowest expecting slot num
+		    && corres.begin() != corres.end() && (corres.begin())->first != next_index); // and lowest slot is still not received
+	};
     };
 
-    template <class T> ratelier_gather<T>::ratelier_gather(unsigned int size, signed int flag):
+    template <class T, class C> ratelier_gather<T, C>::ratelier_gather(unsigned int size, signed int flag):
 	table(size, slot(flag)),
-	verrou(2)
+	verrou(3),
+	stats(size)
     {
 	next_index = 0;
+	resets = 0;
 
 	for(unsigned int i = 0; i < size; ++i)
 	    empty_slot.push_back(i);
     }
 
-    template <class T> void ratelier_gather<T>::worker_push_one(unsigned int slot, std::unique_ptr<T> & one, signed int flag)
+    template <class T, class C> void ratelier_gather<T, C>::worker_push_one(unsigned int slot, std::unique_ptr<T> & one, signed int flag)
     {
-	verrou.lock();
-
 	try
 	{
-	    while(empty_slot.empty()  // no free slot available
-		  || ((empty_slot.size() == 1 && slot != next_index) // one slot available and we do not provide the lowest expecting slot num
-		      && corres.begin() != corres.end() && (corres.begin())->first != next_index)) // and lowest slot is still not received
-		verrou.wait(cond_full);
+	    lock_guard<C> lock(verrou);  // --- critical section up to end of block
+
+	    if(must_wait(slot))
+	    {
+		bool held = ! empty_slot.empty(); // a slot is free but kept for the next index
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		verrou.wait(cond_full, [this, slot]() { return ! must_wait(slot); });
+
+		std::chrono::nanoseconds waited = std::chrono::steady_clock::now() - start;
+		++stats.worker_waits;
+		stats.worker_wait_time += waited;
+		if(held)
+		{
+		    ++stats.single_slot_holds;
+		    stats.single_slot_hold_time += waited;
+		}
+	    }
 
 	    std::map<unsigned int, unsigned int>::iterator it = corres.find(slot);
 	    unsigned int index;
@@ -198,6 +281,8 @@ namespace libthreadar
 	    table[index].flag = flag;
 
 	    empty_slot.pop_back();
+	    ++stats.pushed;
+	    ++(stats.depth[corres.size()]);
 
 	    if(verrou.get_waiting_thread_count(cond_pending_data) > 0)
 		if(corres.find(next_index) != corres.end()) // some data can be gathered
@@ -205,102 +290,171 @@ namespace libthreadar
 	}
 	catch(...)
 	{
-	    verrou.unlock(); // unlock first, as broadcast/signal may be the cause of the exception
+		// the lock has been released by lock_guard, as broadcast/signal may be the cause of the exception
 	    verrou.broadcast(cond_pending_data);
 	    verrou.broadcast(cond_full);
 	    throw;
 	}
-	verrou.unlock();
     }
 
-    template <class T> void ratelier_gather<T>::gather(std::deque<std::unique_ptr<T> > & ones, std::deque<signed int> & flag)
+    template <class T, class C> void ratelier_gather<T, C>::gather(std::deque<std::unique_ptr<T> > & ones, std::deque<signed int> & flag)
     {
 	ones.clear();
 	flag.clear();
 
-	verrou.lock();
 	try
 	{
+	    lock_guard<C> lock(verrou);  // --- critical section up to end of block
 	    std::map<unsigned int, unsigned int>::iterator it;
 	    std::map<unsigned int, unsigned int>::iterator tmp;
 
-	    do
+	    if(corres.find(next_index) == corres.end())
+	    {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		if(! corres.empty())
+		    ++stats.head_of_line_waits;
+		verrou.wait(cond_pending_data, [this]() { return corres.find(next_index) != corres.end(); });
+		++stats.gather_waits;
+		stats.gather_wait_time += std::chrono::steady_clock::now() - start;
+	    }
+
+	    it = corres.begin();
+
+	    while(it != corres.end())
 	    {
-		it = corres.begin();
+		if(it->first > next_index) // not continuous sequence
+		    break; // exiting the while loop
 
-		while(it != corres.end())
+		if(it->first == next_index)
 		{
-		    if(it->first > next_index) // not continuous sequence
-			break; // exiting the inner while loop
-
-		    if(it->first == next_index)
-		    {
-
-			    // sanity checks
-
-			if(it->second >= table.size())
-			    throw THREADAR_BUG;
-			if(table[it->second].index != next_index)
-			    throw THREADAR_BUG;
-			if(table[it->second].empty)
-			    throw THREADAR_BUG;
-			if( ! table[it->second].obj)
-			    throw THREADAR_BUG;
-
-			    // recording the change
-
-			ones.push_back(std::move(table[it->second].obj));
-			flag.push_back(table[it->second].flag);
-
-			table[it->second].empty = true;
-			empty_slot.push_back(it->second);
-			tmp = it;
-			++it;
-			corres.erase(tmp);
-			++next_index;
-		    }
-		    else // integer overload occured for the index
-			++it; // skipping this entry
-		}
 
-		if(ones.empty())
-		    verrou.wait(cond_pending_data);
+			// sanity checks
+
+		    if(it->second >= table.size())
+			throw THREADAR_BUG;
+		    if(table[it->second].index != next_index)
+			throw THREADAR_BUG;
+		    if(table[it->second].empty)
+			throw THREADAR_BUG;
+
+			// recording the change
+
+		    ones.push_back(std::move(table[it->second].obj));
+		    flag.push_back(table[it->second].flag);
+
+		    table[it->second].empty = true;
+		    empty_slot.push_back(it->second);
+		    tmp = it;
+		    ++it;
+		    corres.erase(tmp);
+		    ++next_index;
+		}
+		else // integer overload occured for the index
+		    ++it; // skipping this entry
 	    }
-	    while(ones.empty());
+
+	    if(ones.empty())
+		throw THREADAR_BUG;
+
+	    if(verrou.get_waiting_thread_count(cond_gathered) > 0)
+		verrou.broadcast(cond_gathered);
 
 	    if(verrou.get_waiting_thread_count(cond_full) > 0)
 		verrou.broadcast(cond_full); // awake all pending workers
 	}
 	catch(...)
 	{
-	    verrou.unlock(); // unlock first, as broadcast() may be the cause of the exception
+		// the lock has been released by lock_guard, as broadcast() may be the cause of the exception
 	    verrou.broadcast(cond_pending_data);
 	    verrou.broadcast(cond_full);
 	    throw;
 	}
-	verrou.unlock();
 
 	if(ones.size() != flag.size())
 	    throw THREADAR_BUG;
     }
 
-    template <class T> void ratelier_gather<T>::reset()
+    template <class T, class C> void ratelier_gather<T, C>::worker_push_flag(unsigned int slot, signed int flag)
     {
-	unsigned int size = table.size();
-	next_index = 0;
-	corres.clear();
-	empty_slot.clear();
+	std::unique_ptr<T> none;
 
-	for(unsigned int i = 0; i < size; ++i)
+	worker_push_one(slot, none, flag);
+    }
+
+    template <class T, class C> void ratelier_gather<T, C>::wait_gathered(unsigned int slot)
+    {
+	lock_guard<C> lock(verrou);
+	unsigned int reset_count = resets;
+
+	    // slot has been gathered once next_index is past it,
+	    // the signed difference stays correct when the index overflows
+	verrou.wait(cond_gathered,
+		    [this, slot, reset_count]() { return static_cast<signed int>(next_index - slot) > 0 || reset_count != resets; });
+    }
+
+    template <class T, class C> typename ratelier_gather<T, C>::statistics ratelier_gather<T, C>::get_statistics() const
+    {
+	statistics ret;
+
+	verrou.lock();
+	try
 	{
-	    table[i].obj.reset();
-	    table[i].empty = true;
-	    empty_slot.push_back(i);
+	    ret = stats;
 	}
+	catch(...)
+	{
+	    verrou.unlock();
+	    throw;
+	}
+	verrou.unlock();
 
+	return ret;
+    }
+
+    template <class T, class C> void ratelier_gather<T, C>::reset_statistics()
+    {
 	verrou.lock();
-	verrou.broadcast(cond_pending_data);
-	verrou.broadcast(cond_full);
+	try
+	{
+	    stats = statistics(table.size());
+	}
+	catch(...)
+	{
+	    verrou.unlock();
+	    throw;
+	}
+	verrou.unlock();
+    }
+
+    template <class T, class C> void ratelier_gather<T, C>::reset()
+    {
+	unsigned int size = table.size();
+
+	verrou.lock();
+	try
+	{
+	    next_index = 0;
+	    corres.clear();
+	    empty_slot.clear();
+
+	    for(unsigned int i = 0; i < size; ++i)
+	    {
+		table[i].obj.reset();
+		table[i].empty = true;
+		empty_slot.push_back(i);
+	    }
+
+	    ++resets;
+	    verrou.broadcast(cond_pending_data);
+	    verrou.broadcast(cond_full);
+	    verrou.broadcast(cond_gathered);
+	}
+	catch(...)
+	{
+	    verrou.unlock();
+	    throw;
+	}
 	verrou.unlock();
     }
 
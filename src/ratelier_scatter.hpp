@@ -38,9 +38,12 @@ extern "C"
 #include <map>
 #include <deque>
 #include <memory>
+#include <chrono>
 
     // libthreadar headers
 #include "mutex.hpp"
+#include "condition.hpp"
+#include "lock_guard.hpp"
 
 
 namespace libthreadar
@@ -60,11 +63,32 @@ namespace libthreadar
 	///
 	/// The number of slot should be greater than the expected number of worker that
 	/// will fetch data, for they dont stay pending for the scattering thread to refill the structure with new data.
+	///
+	/// When workers keep per-stream state (dictionaries, hash contexts,...), the scattering thread can
+	/// associate an affinity key to an object: all objects scattered with the same key are then provided to the same
+	/// worker, which has to identify itself when calling worker_get_one(). Objects scattered without key are
+	/// provided to any worker. In any case the index associated to each object follows the scatter() order, so
+	/// the ratelier_gather still provides the results in the original order.
+	///
+	/// Control messages (end of stream, flush requests,...) can be sent to workers without allocating
+	/// any object: scatter_flag() provides a flag alone to a single worker, broadcast_flag() provides
+	/// a flag alone to each worker. Such entries are returned by worker_get_one() as an empty std::unique_ptr
+	/// and use an index like any other object, a worker should thus forward them to the ratelier_gather
+	/// with ratelier_gather::worker_push_flag() for the gathering thread not to wait for the index.
+	///
+	/// The second template argument is the type of the internal lock and conditions, libthreadar::condition
+	/// by default, futex_condition can be used instead to avoid the pthread layer.
 
-    template <class T> class ratelier_scatter
+    template <class T, class C = condition> class ratelier_scatter
     {
     public:
-	ratelier_scatter(unsigned int size, signed int flag = 0);
+	    /// constructor
+
+	    /// \param[in] size number of slots of the ratelier
+	    /// \param[in] flag default flag value of slots
+	    /// \param[in] workers number of workers identifying themselves when calling worker_get_one(),
+	    /// only necessary when objects are scattered with an affinity key
+	ratelier_scatter(unsigned int size, signed int flag = 0, unsigned int workers = 0);
 	ratelier_scatter(const ratelier_scatter & ref) = delete;
 	ratelier_scatter(ratelier_scatter && ref) = default;
 	ratelier_scatter & operator = (const ratelier_scatter & ref) = delete;
@@ -83,21 +107,86 @@ namespace libthreadar
 	    /// is full (if no worker did fetch a job).
 	void scatter(std::unique_ptr<T> & one, signed int flag = 0);
 
+	    /// For the non-worker thread to provide data to a given worker of the ratelier_scatter
+
+	    /// \param one an object to scatter to workers
+	    /// \param flag is a signal available to worker for any purpose it is associated
+	    /// to the provided object in this call
+	    /// \param key affinity key, objects scattered with the same key are all provided to the
+	    /// same worker, the one that identifies itself with the number key modulo the number of workers
+	    /// given at construction time
+	    /// \note this call is only possible if a non zero number of workers was given at construction time
+	void scatter(std::unique_ptr<T> & one, signed int flag, unsigned int key);
+
+	    /// For the non-worker thread to provide a control message to a worker
+
+	    /// \param flag the signal to send to the first worker calling worker_get_one()
+	    /// \return the index associated to this control message, which can be given
+	    /// to ratelier_gather::wait_gathered() to wait for all data scattered so far
+	    /// to have been gathered
+	    /// \note no object is allocated, the worker obtains an empty std::unique_ptr
+	unsigned int scatter_flag(signed int flag);
+
+	    /// For the non-worker thread to provide a control message to each worker
+
+	    /// \param flag the signal to send to each worker
+	    /// \return the index associated to the last control message sent
+	    /// \note this call is only possible if a non zero number of workers was given at construction time,
+	    /// each worker receives this control message once it identifies itself calling worker_get_one(),
+	    /// right after the objects scattered to it before this call.
+	unsigned int broadcast_flag(signed int flag);
+
 	    /// For a worker thread to obtain an object in the lowest slot available
 
 	    /// \param[out] slot the slot associated to the object obtained in return of this call
 	    /// \param[out] flag a signal associated to this object by from the scattering thread
 	    /// \return the next object available from the ratelier_scaller that has been given by
-	    /// the non-worker thread calling the scatter() method
+	    /// the non-worker thread calling the scatter() method, which is empty for control messages
 	    /// \note this call may suspended the caller until the scattering thread feeds
 	    /// the ratelier_scatter with new data
 	std::unique_ptr<T> worker_get_one(unsigned int & slot, signed int & flag);
 
+	    /// For a worker thread identifying itself to obtain an object in the lowest slot available
+
+	    /// \param[out] slot the slot associated to the object obtained in return of this call
+	    /// \param[out] flag a signal associated to this object by from the scattering thread
+	    /// \param[in] worker the worker number, which must be less than the number of workers given at construction time
+	    /// \return the next object available for this worker, either scattered without affinity key
+	    /// or scattered with a key that routes to this worker, the returned object is empty for control messages
+	    /// \note this call may suspended the caller until the scattering thread feeds
+	    /// the ratelier_scatter with new data for this worker
+	std::unique_ptr<T> worker_get_one(unsigned int & slot, signed int & flag, unsigned int worker);
+
+	    /// the number of workers given at construction time
+	unsigned int get_workers() const { return workers; };
+
 	    /// reset the object in its prestine state
 
-	    /// \note this resets the index to zero.
+	    /// \note this resets the index to zero, but not the statistics (see reset_statistics()).
 	void reset();
 
+	    /// counters maintained by the ratelier_scatter to help sizing it
+
+	    /// the scattering thread being often suspended (scatter_waits) shows that workers are the
+	    /// bottleneck, workers being often suspended (worker_waits) shows that the scattering thread is.
+	struct statistics
+	{
+	    unsigned long long scattered;                 ///< number of entries scattered so far
+	    unsigned long long scatter_waits;             ///< number of times the scattering thread was suspended, the ratelier being full
+	    std::chrono::nanoseconds scatter_wait_time;   ///< cumulated time the scattering thread was suspended
+	    unsigned long long worker_waits;              ///< number of times a worker was suspended for lack of data
+	    std::chrono::nanoseconds worker_wait_time;    ///< cumulated time workers were suspended for lack of data
+	    std::vector<unsigned long long> depth;        ///< depth[i] is the number of scatter() calls that found i entries pending in the ratelier
+
+	    statistics(unsigned int size = 0): depth(size + 1, 0) { scattered = scatter_waits = worker_waits = 0; scatter_wait_time = worker_wait_time = std::chrono::nanoseconds::zero(); };
+	};
+
+	    /// obtain a snapshot of the statistics
+	statistics get_statistics() const;
+
+	    /// reset the statistics
+	void reset_statistics();
+
     private:
 
 	static const unsigned int cond_empty = 0; ///< condition when the object is empty and thread is waiting for situation change
@@ -109,39 +198,108 @@ namespace libthreadar
 	    bool empty;               ///< whether this slot is empty or not
 	    unsigned int index;       ///< virtual index of the object
 	    signed int flag;          ///< value of the flag signal (purpose free)
+	    bool affine;              ///< whether the object is reserved to a given worker
+	    unsigned int worker;      ///< the worker the object is reserved to (if affine is true)
 
-	    slot(signed int val) { empty = true; flag = val; };
-	    slot(const slot & ref) { obj.reset(); empty = ref.empty; index = ref.index; flag = ref.flag; };
+	    slot(signed int val) { empty = true; flag = val; affine = false; worker = 0; };
+	    slot(const slot & ref) { obj.reset(); empty = ref.empty; index = ref.index; flag = ref.flag; affine = ref.affine; worker = ref.worker; };
 	};
 
 	unsigned int next_index;       ///< index of the next slot to use (always increases but may overflood)
-	unsigned int lowest_index;     ///< next index to provide to a worker
+	unsigned int lowest_index;     ///< lowest index not yet provided to a worker
+	unsigned int workers;          ///< number of workers for affinity routing
 	std::vector<slot> table;       ///< table of slots to store data
 	std::map<unsigned int, unsigned int> corres; ///< associate infinite range index to index in table
 	std::deque<unsigned int> empty_slot;         ///< empty slot of table
-	libthreadar::condition verrou;               ///< lock to manipulate private data
+	mutable C verrou;                            ///< lock to manipulate private data
+	statistics stats;                            ///< counters about the ratelier usage
+
+	unsigned int push_one(std::unique_ptr<T> & one, signed int flag, bool affine, unsigned int worker);
+	std::unique_ptr<T> get_one(unsigned int & slot, signed int & flag, bool identified, unsigned int worker);
+	std::map<unsigned int, unsigned int>::iterator find_eligible(bool identified, unsigned int worker);
+	bool eligible(unsigned int tableindex, bool identified, unsigned int worker) const;
     };
 
-    template <class T> ratelier_scatter<T>::ratelier_scatter(unsigned int size, signed int flag):
+    template <class T, class C> ratelier_scatter<T, C>::ratelier_scatter(unsigned int size, signed int flag, unsigned int workers):
 	table(size, slot(flag)),
-	verrou(2)
+	verrou(2),
+	stats(size)
     {
 	next_index = 0;
 	lowest_index = 0;
+	this->workers = workers;
 
 	for(unsigned int i = 0; i < size; ++i)
 	    empty_slot.push_back(i);
     }
 
-    template <class T> void ratelier_scatter<T>::scatter(std::unique_ptr<T> & one, signed int flag)
+    template <class T, class C> void ratelier_scatter<T, C>::scatter(std::unique_ptr<T> & one, signed int flag)
+    {
+	(void)push_one(one, flag, false, 0);
+    }
+
+    template <class T, class C> void ratelier_scatter<T, C>::scatter(std::unique_ptr<T> & one, signed int flag, unsigned int key)
+    {
+	if(workers == 0)
+	    throw exception_range("cannot scatter with an affinity key, no worker number given to ratelier_scatter constructor");
+	(void)push_one(one, flag, true, key % workers);
+    }
+
+    template <class T, class C> unsigned int ratelier_scatter<T, C>::scatter_flag(signed int flag)
+    {
+	std::unique_ptr<T> none;
+
+	return push_one(none, flag, false, 0);
+    }
+
+    template <class T, class C> unsigned int ratelier_scatter<T, C>::broadcast_flag(signed int flag)
+    {
+	unsigned int ret = 0;
+
+	if(workers == 0)
+	    throw exception_range("cannot broadcast a flag, no worker number given to ratelier_scatter constructor");
+
+	for(unsigned int w = 0; w < workers; ++w)
+	{
+	    std::unique_ptr<T> none;
+	    ret = push_one(none, flag, true, w);
+	}
+
+	return ret;
+    }
+
+    template <class T, class C> std::unique_ptr<T> ratelier_scatter<T, C>::worker_get_one(unsigned int & slot, signed int & flag)
+    {
+	return get_one(slot, flag, false, 0);
+    }
+
+    template <class T, class C> std::unique_ptr<T> ratelier_scatter<T, C>::worker_get_one(unsigned int & slot, signed int & flag, unsigned int worker)
+    {
+	if(worker >= workers)
+	    throw exception_range("worker number given to ratelier_scatter::worker_get_one() is out of range");
+	return get_one(slot, flag, true, worker);
+    }
+
+    template <class T, class C> unsigned int ratelier_scatter<T, C>::push_one(std::unique_ptr<T> & one, signed int flag, bool affine, unsigned int worker)
     {
 	unsigned int tableindex;
+	unsigned int ret;
 
-	verrou.lock();
 	try
 	{
-	    while(empty_slot.empty()) // ratelier_scatter is full
-		verrou.wait(cond_full);
+	    lock_guard<C> lock(verrou);  // --- critical section up to end of block
+
+	    ++(stats.depth[corres.size()]);
+
+	    if(empty_slot.empty()) // ratelier_scatter is full
+	    {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		verrou.wait(cond_full, [this]() { return ! empty_slot.empty(); });
+
+		++stats.scatter_waits;
+		stats.scatter_wait_time += std::chrono::steady_clock::now() - start;
+	    }
 
 	    tableindex = empty_slot.back();
 
@@ -158,113 +316,209 @@ namespace libthreadar
 	    table[tableindex].obj = std::move(one);
 	    table[tableindex].index = next_index;
 	    table[tableindex].flag = flag;
+	    table[tableindex].affine = affine;
+	    table[tableindex].worker = worker;
 
 	    corres[next_index] = tableindex;
+	    ret = next_index;
 	    ++next_index;
+	    ++stats.scattered;
 
 	    empty_slot.pop_back();
 	    if(verrou.get_waiting_thread_count(cond_empty) > 0)
-		verrou.signal(cond_empty);
+	    {
+		if(affine)
+		    verrou.broadcast(cond_empty); // the worker this object is reserved to may not be the one signal() would awake
+		else
+		    verrou.signal(cond_empty);
+	    }
 	}
 	catch(...)
 	{
-	    verrou.unlock();
+		// the lock has been released by lock_guard, as broadcast/signal may be the cause of the exception
 	    verrou.broadcast(cond_empty);
 	    verrou.broadcast(cond_full);
 	    throw;
 	}
-	verrou.unlock();
+
+	return ret;
     }
 
-    template <class T> std::unique_ptr<T> ratelier_scatter<T>::worker_get_one(unsigned int & slot, signed int & flag)
+    template <class T, class C> std::unique_ptr<T> ratelier_scatter<T, C>::get_one(unsigned int & slot, signed int & flag, bool identified, unsigned int worker)
     {
 	std::unique_ptr<T> ret;
 
-	verrou.lock();
 	try
 	{
-	    std::map<unsigned int, unsigned int>::iterator it = corres.begin();
-		// using sequential reading provides sorted scanning
-		// of the map, looking first for the lowest index available (oldest entries)
+	    lock_guard<C> lock(verrou);  // --- critical section up to end of block
+	    std::map<unsigned int, unsigned int>::iterator it = find_eligible(identified, worker);
 
-	    do
+	    if(it == corres.end())
 	    {
-		if(it != corres.end())
-		{
-		    if(it->first < lowest_index) // overflooding occured
-			++it; // ignoring this slot
-		    else
-		    {
-
-			    // sanity checks
-
-			if(it->second >= table.size())
-			    throw THREADAR_BUG;
-			if(table[it->second].empty)
-			    throw THREADAR_BUG;
-			if( ! table[it->second].obj)
-			    throw THREADAR_BUG;
-
-			    // recording the change
-
-			ret = std::move(table[it->second].obj);
-			slot = table[it->second].index;
-			flag = table[it->second].flag;
-			table[it->second].empty = true;
-
-			if(lowest_index != slot)
-			    throw THREADAR_BUG;
-			++lowest_index;
-
-			    // reusing quicker the last block used
-			    // as the back() be used first
-			empty_slot.push_back(it->second);
-			corres.erase(it); // removing the correspondance
-
-			if(verrou.get_waiting_thread_count(cond_full) > 0)
-			    verrou.signal(cond_full);
-		    }
-		}
+		    // ratelier_scatter is empty or has nothing for this worker
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		verrou.wait(cond_empty, [this, &it, identified, worker]()
+			    {
+				it = find_eligible(identified, worker);
+				return it != corres.end();
+			    });
+
+		++stats.worker_waits;
+		stats.worker_wait_time += std::chrono::steady_clock::now() - start;
+	    }
+
+		// sanity checks
+
+	    if(it->second >= table.size())
+		throw THREADAR_BUG;
+	    if(table[it->second].empty)
+		throw THREADAR_BUG;
+
+		// recording the change
+
+	    ret = std::move(table[it->second].obj); // empty for control messages
+	    slot = table[it->second].index;
+	    flag = table[it->second].flag;
+	    table[it->second].empty = true;
+	    table[it->second].affine = false;
+
+		// reusing quicker the last block used
+		// as the back() be used first
+	    empty_slot.push_back(it->second);
+	    corres.erase(it); // removing the correspondance
+
+	    if(slot == lowest_index)
+	    {
+		    // objects reserved to another worker may have been
+		    // left behind, lowest_index is the oldest remaining entry
+		if(corres.empty())
+		    lowest_index = next_index;
 		else
 		{
-			// ratelier_scatter is empty
-
-		    verrou.wait(cond_empty);
-		    it = corres.begin();
+		    it = corres.lower_bound(lowest_index);
+		    if(it == corres.end())
+			it = corres.begin(); // index overflooded
+		    lowest_index = it->first;
 		}
 	    }
-	    while( ! ret);
+
+	    if(verrou.get_waiting_thread_count(cond_full) > 0)
+		verrou.signal(cond_full);
 	}
 	catch(...)
 	{
-	    verrou.unlock();
+		// the lock has been released by lock_guard, as broadcast/signal may be the cause of the exception
 	    verrou.broadcast(cond_empty);
 	    verrou.broadcast(cond_full);
 	    throw;
 	}
-	verrou.unlock();
 
 	return ret;
     }
 
-    template <class T> void ratelier_scatter<T>::reset()
+    template <class T, class C> std::map<unsigned int, unsigned int>::iterator ratelier_scatter<T, C>::find_eligible(bool identified, unsigned int worker)
     {
-	unsigned int size = table.size();
-	next_index = 0;
-	lowest_index = 0;
-	corres.clear();
-	empty_slot.clear();
+	    // scanning the map from lowest_index up to its end then
+	    // from its beginning, provides the entries in scatter order
+	    // even when the index overflooded
+	std::map<unsigned int, unsigned int>::iterator start = corres.lower_bound(lowest_index);
+	std::map<unsigned int, unsigned int>::iterator it = start;
+	bool wrapped = false;
+
+	while(true)
+	{
+	    if(it == corres.end())
+	    {
+		if(wrapped)
+		    return corres.end();
+		wrapped = true;
+		it = corres.begin();
+	    }
 
-	for(unsigned int i = 0; i < size; ++i)
+	    if(wrapped && it == start)
+		return corres.end();
+
+	    if(eligible(it->second, identified, worker))
+		return it;
+	    ++it;
+	}
+    }
+
+    template <class T, class C> bool ratelier_scatter<T, C>::eligible(unsigned int tableindex, bool identified, unsigned int worker) const
+    {
+	if(tableindex >= table.size())
+	    throw THREADAR_BUG;
+
+	if(! table[tableindex].affine)
+	    return true;
+	else
+	    return identified && table[tableindex].worker == worker;
+    }
+
+    template <class T, class C> typename ratelier_scatter<T, C>::statistics ratelier_scatter<T, C>::get_statistics() const
+    {
+	statistics ret;
+
+	verrou.lock();
+	try
 	{
-	    table[i].obj.reset();
-	    table[i].empty = true;
-	    empty_slot.push_back(i);
+	    ret = stats;
 	}
+	catch(...)
+	{
+	    verrou.unlock();
+	    throw;
+	}
+	verrou.unlock();
+
+	return ret;
+    }
 
+    template <class T, class C> void ratelier_scatter<T, C>::reset_statistics()
+    {
 	verrou.lock();
-	verrou.broadcast(cond_empty);
-	verrou.broadcast(cond_full);
+	try
+	{
+	    stats = statistics(table.size());
+	}
+	catch(...)
+	{
+	    verrou.unlock();
+	    throw;
+	}
+	verrou.unlock();
+    }
+
+    template <class T, class C> void ratelier_scatter<T, C>::reset()
+    {
+	unsigned int size = table.size();
+
+	verrou.lock();
+	try
+	{
+	    next_index = 0;
+	    lowest_index = 0;
+	    corres.clear();
+	    empty_slot.clear();
+
+	    for(unsigned int i = 0; i < size; ++i)
+	    {
+		table[i].obj.reset();
+		table[i].empty = true;
+		table[i].affine = false;
+		empty_slot.push_back(i);
+	    }
+
+	    verrou.broadcast(cond_empty);
+	    verrou.broadcast(cond_full);
+	}
+	catch(...)
+	{
+	    verrou.unlock();
+	    throw;
+	}
 	verrou.unlock();
     }
 
@@ -0,0 +1,309 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+}
+    // C++ standard headers
+#include <new>
+
+    // libthreadar headers
+#include "tools.hpp"
+
+    // this module's header
+#include "rwlock.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+	// slot index of the calling thread, assigned at first use
+	// from a global counter so threads spread over the slots
+
+    static atomic<unsigned int> next_slot(0);
+    static thread_local unsigned int thread_slot = 0;
+    static thread_local bool thread_slot_set = false;
+
+    rwlock::rwlock(mode m, unsigned int slots_num): md(m), writer(no_writer)
+    {
+	num_slots = 0;
+
+	switch(md)
+	{
+	case mode::system:
+	    {
+		pthread_rwlockattr_t attr;
+		int ret = pthread_rwlockattr_init(&attr);
+
+		if(ret != 0)
+		    throw exception_system("Failed initializing rwlock attributes: ", ret);
+
+#if HAVE_PTHREAD_RWLOCKATTR_SETKIND_NP
+		    // glibc prefers readers by default, which may starve writers
+		ret = pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+		if(ret != 0)
+		{
+		    (void)pthread_rwlockattr_destroy(&attr);
+		    throw exception_system("Failed setting rwlock writer preference: ", ret);
+		}
+#endif
+		ret = pthread_rwlock_init(&rw, &attr);
+		(void)pthread_rwlockattr_destroy(&attr);
+		if(ret != 0)
+		    throw exception_system("Failed creating rwlock: ", ret);
+	    }
+	    break;
+	case mode::scalable:
+	    if(slots_num == 0)
+	    {
+		long cpus = 1;
+
+#if HAVE_UNISTD_H
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+		slots_num = cpus > 1 ? (unsigned int)cpus : 1;
+	    }
+	    slots.reset(new (nothrow) slot[slots_num]);
+	    if(! slots)
+		throw exception_memory();
+	    num_slots = slots_num;
+	    break;
+	default:
+	    throw THREADAR_BUG;
+	}
+    }
+
+    rwlock::~rwlock()
+    {
+	if(md == mode::system)
+	    (void)pthread_rwlock_destroy(&rw);
+    }
+
+    void rwlock::lock()
+    {
+	switch(md)
+	{
+	case mode::system:
+	    {
+		int ret = pthread_rwlock_wrlock(&rw);
+		if(ret != 0)
+		    throw exception_system("Failed acquiring rwlock for writing: ", ret);
+	    }
+	    break;
+	case mode::scalable:
+	    {
+		unsigned int round = 0;
+
+		writers.lock();
+
+		    // new readers now back off, waiting for
+		    // the ones already present to leave
+		writer.store(writer_present);
+		while(readers_present())
+		    tools_spin_pause(round);
+	    }
+	    break;
+	default:
+	    throw THREADAR_BUG;
+	}
+    }
+
+    void rwlock::unlock()
+    {
+	switch(md)
+	{
+	case mode::system:
+	    {
+		int ret = pthread_rwlock_unlock(&rw);
+		if(ret != 0)
+		    throw exception_system("Failed releasing rwlock: ", ret);
+	    }
+	    break;
+	case mode::scalable:
+	    if(writer.exchange(no_writer) == readers_sleeping)
+		futex::wake_all(writer);
+	    writers.unlock();
+	    break;
+	default:
+	    throw THREADAR_BUG;
+	}
+    }
+
+    bool rwlock::try_lock()
+    {
+	switch(md)
+	{
+	case mode::system:
+	    {
+		int ret = pthread_rwlock_trywrlock(&rw);
+
+		switch(ret)
+		{
+		case 0:
+		    return true;
+		case EBUSY:
+		    return false;
+		default:
+		    throw exception_system("Failed acquiring rwlock for writing: ", ret);
+		}
+	    }
+	case mode::scalable:
+	    if(! writers.try_lock())
+		return false;
+	    writer.store(writer_present);
+	    if(readers_present())
+	    {
+		unlock();
+		return false;
+	    }
+	    return true;
+	default:
+	    throw THREADAR_BUG;
+	}
+    }
+
+    void rwlock::lock_shared()
+    {
+	switch(md)
+	{
+	case mode::system:
+	    {
+		int ret = pthread_rwlock_rdlock(&rw);
+		if(ret != 0)
+		    throw exception_system("Failed acquiring rwlock for reading: ", ret);
+	    }
+	    break;
+	case mode::scalable:
+	    {
+		atomic<int> & readers = my_slot().readers;
+
+		while(true)
+		{
+			// announcing ourself then checking for a writer,
+			// the writer does the opposite, so at least one
+			// of the two sees the other
+
+		    readers.fetch_add(1);
+		    if(writer.load() == no_writer)
+			break;
+
+			// a writer holds or waits for the lock, stepping back
+		    readers.fetch_sub(1);
+
+		    int current = writer.load();
+		    if(current == writer_present)
+		    {
+			if(! writer.compare_exchange_strong(current, readers_sleeping))
+			    continue;
+			current = readers_sleeping;
+		    }
+		    if(current == readers_sleeping)
+			futex::wait(writer, readers_sleeping);
+		}
+	    }
+	    break;
+	default:
+	    throw THREADAR_BUG;
+	}
+    }
+
+    void rwlock::unlock_shared()
+    {
+	switch(md)
+	{
+	case mode::system:
+	    unlock();
+	    break;
+	case mode::scalable:
+	    my_slot().readers.fetch_sub(1, memory_order_release);
+	    break;
+	default:
+	    throw THREADAR_BUG;
+	}
+    }
+
+    bool rwlock::try_lock_shared()
+    {
+	switch(md)
+	{
+	case mode::system:
+	    {
+		int ret = pthread_rwlock_tryrdlock(&rw);
+
+		switch(ret)
+		{
+		case 0:
+		    return true;
+		case EBUSY:
+		    return false;
+		default:
+		    throw exception_system("Failed acquiring rwlock for reading: ", ret);
+		}
+	    }
+	case mode::scalable:
+	    {
+		atomic<int> & readers = my_slot().readers;
+
+		readers.fetch_add(1);
+		if(writer.load() == no_writer)
+		    return true;
+		readers.fetch_sub(1);
+		return false;
+	    }
+	default:
+	    throw THREADAR_BUG;
+	}
+    }
+
+    rwlock::slot & rwlock::my_slot()
+    {
+	if(! thread_slot_set)
+	{
+	    thread_slot = next_slot.fetch_add(1, memory_order_relaxed);
+	    thread_slot_set = true;
+	}
+
+	return slots[thread_slot % num_slots];
+    }
+
+    bool rwlock::readers_present() const
+    {
+	for(unsigned int i = 0; i < num_slots; ++i)
+	    if(slots[i].readers.load() != 0)
+		return true;
+
+	return false;
+    }
+
+} // end of namespace
@@ -0,0 +1,151 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_RWLOCK_HPP
+#define LIBTHREADAR_RWLOCK_HPP
+
+    /// \file rwlock.hpp
+    /// \brief defines the rwlock class, a reader-writer lock
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+#if HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+}
+    // C++ standard headers
+#include <atomic>
+#include <memory>
+
+    // libthreadar headers
+#include "exceptions.hpp"
+#include "futex_mutex.hpp"
+
+namespace libthreadar
+{
+
+	/// Class rwlock lets several threads read a data at the same time while writers get exclusive access
+
+	/// Threads only reading the protected data call lock_shared() and unlock_shared(), any number
+	/// of them can hold the lock at the same time. Threads modifying the data call lock() and unlock()
+	/// (same interface as libthreadar::mutex), and get the lock alone. Writers are preferred:
+	/// once a writer waits for the lock, new readers wait for it to be released.
+	///
+	/// Two implementations are available, selected at construction time:
+	/// - mode::system relies on pthread_rwlock_t
+	/// - mode::scalable keeps one reader counter per slot, each slot on its own cache line, a thread
+	///   always using the same slot. Concurrent readers thus do not write to a shared cache line,
+	///   which scales to many reading CPUs, at the cost of writers having to scan all slots.
+	///   Writers wait for readers by yielding the CPU, this mode is thus intended for read-mostly
+	///   data with short read sections.
+	///
+	/// \note unlock_shared() must be called by the thread that called lock_shared()
+	/// \note the lock is not recursive: a thread holding the lock must not lock it again
+    class rwlock
+    {
+    public:
+	    /// implementation of the lock
+	enum class mode
+	{
+	    system,   ///< pthread_rwlock_t based
+	    scalable  ///< per slot reader counters
+	};
+
+	    /// constructor
+
+	    /// \param[in] m implementation to use
+	    /// \param[in] slots number of reader slots in scalable mode, zero for the number of online CPUs
+	rwlock(mode m = mode::system, unsigned int slots = 0);
+
+	    /// no copy constructor
+	rwlock(const rwlock & ref) = delete;
+
+	    /// no move constructor
+	rwlock(rwlock && ref) = delete;
+
+	    /// no assignment operator
+	rwlock & operator = (const rwlock & ref) = delete;
+
+	    /// no move operator
+	rwlock & operator = (rwlock && ref) = delete;
+
+	    /// destructor
+	~rwlock();
+
+	    /// acquire the lock for writing, waiting for readers and other writers to release it
+	void lock();
+
+	    /// release the lock acquired for writing
+	void unlock();
+
+	    /// acquire the lock for writing if no other thread holds it
+
+	    /// \return true if the lock is acquired
+	bool try_lock();
+
+	    /// acquire the lock for reading, waiting for the writer to release it if any
+	void lock_shared();
+
+	    /// release the lock acquired for reading
+	void unlock_shared();
+
+	    /// acquire the lock for reading if no writer holds or waits for it
+
+	    /// \return true if the lock is acquired
+	bool try_lock_shared();
+
+	    /// the implementation used
+	mode get_mode() const { return md; };
+
+    private:
+	static const int no_writer = 0;          ///< writer value when no writer holds or waits for the lock
+	static const int writer_present = 1;     ///< a writer holds or waits for the lock
+	static const int readers_sleeping = 2;   ///< same as writer_present, some readers are suspended on writer
+
+	    /// reader counter on its own cache line
+	struct slot
+	{
+	    std::atomic<int> readers;
+	    char pad[64 - sizeof(std::atomic<int>)];
+
+	    slot(): readers(0) {};
+	};
+
+	mode md;                          ///< implementation used
+	pthread_rwlock_t rw;              ///< lock used in system mode
+	futex_mutex writers;              ///< serializes writers in scalable mode
+	std::atomic<int> writer;          ///< in scalable mode, one of the three values above
+	std::unique_ptr<slot[]> slots;    ///< in scalable mode, the reader counters
+	unsigned int num_slots;           ///< size of the slots array
+
+	slot & my_slot();
+	bool readers_present() const;
+    };
+
+} // end of namespace
+
+#endif
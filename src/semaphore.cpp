@@ -46,82 +46,123 @@ namespace libthreadar
     semaphore::semaphore(unsigned int max_val) : max_value(max_val)
     {
 	value = max_val;
-	semaph.lock(); // now semaph will suspend thread for which lock() is called
+	released = 0;
     }
 
     semaphore::~semaphore()
     {
 	reset();
-	semaph.unlock();
     }
 
     bool semaphore::waiting_thread() const
     {
-	return value < 0; // reading of integer is atomic CPU single operation, no need to lock val_mutex
+	return value < 0; // reading of integer is atomic CPU single operation, no need to lock cond
     }
 
     bool semaphore::working_thread() const
     {
-	return value < max_value; // reading of integer is atomic CPU single operation, no need to lock val_mutex
+	return value < max_value; // reading of integer is atomic CPU single operation, no need to lock cond
     }
 
     void semaphore::lock()
     {
-	bool locking = false;
-
-	val_mutex.lock();
-	--value;
-	if(value < 0)
-	    locking = true;
-	val_mutex.unlock();
+	lock_with(nullptr);
+    }
 
-	if(locking)
-	    semaph.lock();
+    void semaphore::lock(const cancellation_token & token)
+    {
+	lock_with(&token);
     }
 
     void semaphore::unlock()
     {
-	bool unlocking = false;
-
-	val_mutex.lock();
+	cond.lock();
 	try
 	{
 	    if(value == max_value)
 		throw exception_range("too much call to unlock() given the number of lock() so far");
 	    ++value;
-	    if(value <= 0)
-		unlocking = true;
+	    if(value <= 0) // value was negative, meaning at least one thread was waiting
+	    {
+		++released;
+		cond.signal();
+	    }
 	}
 	catch(...)
 	{
-	    val_mutex.unlock();
+	    cond.unlock();
 	    throw;
 	}
-	val_mutex.unlock();
-
-	if(unlocking) // value was negative at the beginning of this call, meaning at least one thread was waiting
-	    semaph.unlock();
+	cond.unlock();
     }
 
     void semaphore::reset()
     {
-	val_mutex.lock();
+	cond.lock();
 	try
 	{
 	    while(value < 0)
 	    {
-		semaph.unlock();
+		++released;
+		cond.signal();
 		++value;
 	    }
 	    value = max_value;
 	}
 	catch(...)
 	{
-	    val_mutex.unlock();
+	    cond.unlock();
 	    throw;
 	}
-	val_mutex.unlock();
+	cond.unlock();
     }
 
+    void semaphore::lock_with(const cancellation_token *token)
+    {
+	cond.lock();
+	try
+	{
+	    --value;
+	    if(value < 0)
+	    {
+		try
+		{
+		    while(released == 0)
+		    {
+			if(token != nullptr)
+			    cond.wait(0, *token);
+			else
+			    cond.wait();
+		    }
+		}
+		catch(...)
+		{
+			// cancelled while waiting, if more threads were awaken
+			// than remain waiting one of these wake-ups was for us
+		    if(released > cond.get_waiting_thread_count())
+		    {
+			    // giving back what we have been given
+			--released;
+			++value;
+			if(value <= 0)
+			{
+			    ++released;
+			    cond.signal();
+			}
+		    }
+		    else
+			++value;
+		    throw;
+		}
+		--released;
+	    }
+	}
+	catch(...)
+	{
+	    cond.unlock();
+	    throw;
+	}
+	cond.unlock();
+    }
 
 } // end of namespace
@@ -40,7 +40,7 @@ extern "C"
 
 
     // libthreadar headers
-#include "mutex.hpp"
+#include "condition.hpp"
 
 namespace libthreadar
 {
@@ -95,6 +95,12 @@ namespace libthreadar
 	    /// resource will be used at the same time.
 	void lock();
 
+	    /// Request a "resource" unless the given token is cancelled
+
+	    /// same as lock() but if the caller is suspended, it is awaken when the token
+	    /// is cancelled and thread::cancel_except is thrown, no resource being acquired.
+	void lock(const cancellation_token & token);
+
 	    /// Release a "resource"
 
 	    /// \note Note that if one or more thread are suspended due to a call to lock() a single thread is awaken
@@ -112,9 +118,11 @@ namespace libthreadar
 
     private:
 	int value;            //< this is the semaphore value
-	mutex val_mutex;      //< this controls modification to value
-	mutex semaph;         //< this mutex is used to suspend thread semaphore value get negative
+	unsigned int released;//< number of suspended threads awaken by unlock() that have not yet returned from lock()
+	condition cond;       //< this controls modification to value and suspends threads when value get negative
 	int max_value;        //< maximum value the semaphore cannot exceed
+
+	void lock_with(const cancellation_token *token);
     };
 
 } // end of namespace
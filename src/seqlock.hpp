@@ -0,0 +1,218 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_SEQLOCK_HPP
+#define LIBTHREADAR_SEQLOCK_HPP
+
+    /// \file seqlock.hpp
+    /// \brief defines the seqlock template class, a sequence lock for small frequently read data
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+    // libthreadar headers
+#include "futex_mutex.hpp"
+#include "tools.hpp"
+
+namespace libthreadar
+{
+
+	/// Class seqlock publishes a small data read very often and modified rarely
+
+	/// Readers never write to shared memory: load() reads a sequence counter, copies the
+	/// data and reads the counter again, retrying if a writer modified the data meanwhile.
+	/// Writers make the counter odd during the modification, and are serialized
+	/// by a lock of type L (futex_mutex by default, any class with lock() and unlock() methods
+	/// can be used, like spin_mutex or libthreadar::mutex).
+	///
+	/// Readers are thus never blocked by other readers and do not bounce any cache line,
+	/// which suits data read at each block of a processing loop (current throughput,
+	/// rate limits, configuration versions...). A reader may retry while a writer updates
+	/// the data, writers should thus be rare and quick.
+	///
+	/// \note T must be trivially copyable (no pointer to owned resource, no virtual method),
+	/// and should be small as it is copied at each read
+	/// \note the data is stored as an array of machine words accessed atomically, so
+	/// concurrent reads and writes are not data races in the C++ memory model
+    template <class T, class L = futex_mutex> class seqlock
+    {
+    public:
+	    /// constructor
+
+	    /// \param[in] val initial value of the data
+	seqlock(const T & val = T());
+
+	    /// no copy constructor
+	seqlock(const seqlock & ref) = delete;
+
+	    /// no move constructor
+	seqlock(seqlock && ref) = delete;
+
+	    /// no assignment operator
+	seqlock & operator = (const seqlock & ref) = delete;
+
+	    /// no move operator
+	seqlock & operator = (seqlock && ref) = delete;
+
+	    /// destructor
+	~seqlock() = default;
+
+	    /// read a consistent copy of the data, retrying as long as a writer modifies it
+	T load() const;
+
+	    /// try reading the data once
+
+	    /// \param[out] val set to the data if the read succeeded
+	    /// \return false if a writer modified the data during the read, val is then undefined
+	bool try_load(T & val) const;
+
+	    /// replace the data
+	void store(const T & val);
+
+	    /// modify the data in place
+
+	    /// \param[in] fn callable object taking a T & argument, called under the writer lock
+	    /// with the current data, the data is published when fn returns
+	template <class F> void update(F fn);
+
+	    /// number of modifications done since the object creation
+	unsigned long get_version() const { return seq.load(std::memory_order_acquire) / 2; };
+
+    private:
+	typedef unsigned long word;
+	static const unsigned int num_words = (sizeof(T) + sizeof(word) - 1) / sizeof(word);
+
+	std::atomic<unsigned long> seq;     ///< odd while a writer modifies the data
+	std::atomic<word> data[num_words];  ///< the data as an array of words
+	L writers;                          ///< serializes writers
+
+	void read_words(word *buf) const;
+	void write_words(const word *buf);
+
+	static_assert(std::is_trivially_copyable<T>::value, "seqlock data must be trivially copyable");
+    };
+
+    template <class T, class L> seqlock<T, L>::seqlock(const T & val): seq(0)
+    {
+	word buf[num_words];
+
+	memset(buf, 0, sizeof(buf));
+	memcpy(buf, &val, sizeof(T));
+	for(unsigned int i = 0; i < num_words; ++i)
+	    data[i].store(buf[i], std::memory_order_relaxed);
+    }
+
+    template <class T, class L> T seqlock<T, L>::load() const
+    {
+	T ret;
+	unsigned int round = 0;
+
+	while(! try_load(ret))
+	    tools_spin_pause(round);
+
+	return ret;
+    }
+
+    template <class T, class L> bool seqlock<T, L>::try_load(T & val) const
+    {
+	word buf[num_words];
+	unsigned long before = seq.load(std::memory_order_acquire);
+
+	if(before % 2 != 0)
+	    return false; // a writer is modifying the data
+
+	read_words(buf);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if(seq.load(std::memory_order_relaxed) != before)
+	    return false;
+
+	memcpy(&val, buf, sizeof(T));
+	return true;
+    }
+
+    template <class T, class L> void seqlock<T, L>::store(const T & val)
+    {
+	word buf[num_words];
+
+	memset(buf, 0, sizeof(buf));
+	memcpy(buf, &val, sizeof(T));
+
+	writers.lock();
+	write_words(buf);
+	writers.unlock();
+    }
+
+    template <class T, class L> template <class F> void seqlock<T, L>::update(F fn)
+    {
+	word buf[num_words];
+	T val;
+
+	writers.lock();
+	try
+	{
+		// no writer can modify the data as we hold the lock
+	    read_words(buf);
+	    memcpy(&val, buf, sizeof(T));
+	    fn(val);
+	    memcpy(buf, &val, sizeof(T));
+	    write_words(buf);
+	}
+	catch(...)
+	{
+	    writers.unlock();
+	    throw;
+	}
+	writers.unlock();
+    }
+
+    template <class T, class L> void seqlock<T, L>::read_words(word *buf) const
+    {
+	for(unsigned int i = 0; i < num_words; ++i)
+	    buf[i] = data[i].load(std::memory_order_relaxed);
+    }
+
+    template <class T, class L> void seqlock<T, L>::write_words(const word *buf)
+    {
+	    // must be called with the writers lock acquired
+
+	unsigned long current = seq.load(std::memory_order_relaxed);
+
+	seq.store(current + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	for(unsigned int i = 0; i < num_words; ++i)
+	    data[i].store(buf[i], std::memory_order_relaxed);
+	seq.store(current + 2, std::memory_order_release);
+    }
+
+} // end of namespace
+
+#endif
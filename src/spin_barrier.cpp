@@ -0,0 +1,97 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+
+    // libthreadar headers
+#include "futex.hpp"
+#include "tools.hpp"
+
+    // this module's header
+#include "spin_barrier.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+    spin_barrier::spin_barrier(unsigned int num, unsigned int spin): val(num), spin_budget(spin), remaining(num), phase(0), sleepers(0)
+    {
+	if(num < 1)
+	    throw exception_range("zero given as argument to spin_barrier");
+    }
+
+    bool spin_barrier::wait()
+    {
+	    // the phase cannot change before we have decremented the counter,
+	    // so this is the phase we are part of
+	int current = phase.load(memory_order_relaxed);
+
+	if(remaining.fetch_sub(1, memory_order_acq_rel) == 1)
+	{
+		// no other thread touches the counter before we change the phase
+	    remaining.store(val, memory_order_relaxed);
+	    next_phase(phase, sleepers);
+	    return true;
+	}
+	else
+	{
+	    wait_phase(phase, current, sleepers, spin_budget);
+	    return false;
+	}
+    }
+
+    void spin_barrier::wait_phase(atomic<int> & phase, int current, atomic<unsigned int> & sleepers, unsigned int spin)
+    {
+	unsigned int round = 0;
+
+	for(unsigned int i = 0; i < spin; ++i)
+	{
+	    if(phase.load(memory_order_acquire) != current)
+		return;
+	    tools_spin_pause(round);
+	}
+
+	    // both operations are sequentially consistent as in next_phase(), so
+	    // either the last thread sees us sleeping or we see the new phase
+	sleepers.fetch_add(1);
+	while(phase.load() == current)
+	    futex::wait(phase, current);
+	sleepers.fetch_sub(1, memory_order_relaxed);
+    }
+
+    void spin_barrier::next_phase(atomic<int> & phase, atomic<unsigned int> & sleepers)
+    {
+	phase.fetch_add(1);
+	if(sleepers.load() > 0)
+	    futex::wake_all(phase);
+    }
+
+} // end of namespace
@@ -0,0 +1,123 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_SPIN_BARRIER_HPP
+#define LIBTHREADAR_SPIN_BARRIER_HPP
+
+    /// \file spin_barrier.hpp
+    /// \brief defines the spin_barrier class, a barrier spinning before suspending the threads
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+
+    // libthreadar headers
+#include "exceptions.hpp"
+
+namespace libthreadar
+{
+
+	/// Class spin_barrier is a sense reversing barrier for threads synchronizing often
+
+	/// It has the same purpose as libthreadar::barrier: the threads calling wait() are
+	/// held until 'num' of them have called it. Each thread decrements a shared counter,
+	/// the last one resets it and changes the phase number (the "sense" of the barrier),
+	/// which all other threads poll. When computation phases are a few microseconds apart,
+	/// the threads are released without having been suspended. A thread still waiting after
+	/// the spin budget has elapsed sleeps on the phase number with futex, the last thread
+	/// only calling the kernel if some thread sleeps.
+	///
+	/// \note the counter is a single cache line all threads write to, for more than
+	/// about 32 threads tree_barrier spreads the arrivals over several cache lines
+	/// \note wait() is not a cancellation point
+    class spin_barrier
+    {
+    public:
+	    /// default number of rounds a thread spins before sleeping
+	static const unsigned int default_spin = 2000;
+
+	    /// constructor
+
+	    /// \param[in] num is the number of threads to synchronize
+	    /// \param[in] spin number of rounds a thread spins waiting for the others before
+	    /// sleeping, zero to sleep immediately. Past a few hundred rounds the spinning
+	    /// threads yield the CPU between each round, which keeps spinning bearable when
+	    /// there are more threads than CPUs
+	spin_barrier(unsigned int num, unsigned int spin = default_spin);
+
+	    /// no copy constructor
+	spin_barrier(const spin_barrier & ref) = delete;
+
+	    /// no move constructor
+	spin_barrier(spin_barrier && ref) = delete;
+
+	    /// no assignment operator
+	spin_barrier & operator = (const spin_barrier & ref) = delete;
+
+	    /// no move operator
+	spin_barrier & operator = (spin_barrier && ref) = delete;
+
+	    /// destructor
+
+	    /// \note A barrier object must not be destroyed if some thread are waiting on it
+	~spin_barrier() = default;
+
+	    /// suspend the calling thread up to the time 'num' threads have called wait()
+
+	    /// \return true for exactly one of the threads, the last to arrive, which can
+	    /// be used to run a serial step between two parallel phases
+	bool wait();
+
+	    /// return the barrier size
+	unsigned int get_count() const { return val; };
+
+	    /// return the number of rounds threads spin before sleeping
+	unsigned int get_spin() const { return spin_budget; };
+
+    private:
+	unsigned int val;                  ///< number of threads to synchronize
+	unsigned int spin_budget;          ///< number of spinning rounds before sleeping
+	std::atomic<unsigned int> remaining; ///< number of threads still expected for the current phase
+	char pad1[64 - sizeof(std::atomic<unsigned int>)];
+	std::atomic<int> phase;            ///< incremented each time the threads are released, futex word
+	std::atomic<unsigned int> sleepers; ///< number of threads sleeping on phase
+	char pad2[64 - sizeof(std::atomic<int>) - sizeof(std::atomic<unsigned int>)];
+
+	    /// wait for phase to change from the given value
+	static void wait_phase(std::atomic<int> & phase, int current, std::atomic<unsigned int> & sleepers, unsigned int spin);
+
+	    /// change the phase releasing the waiting threads
+	static void next_phase(std::atomic<int> & phase, std::atomic<unsigned int> & sleepers);
+
+	friend class tree_barrier;
+    };
+
+} // end of namespace
+
+#endif
@@ -0,0 +1,99 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_SPIN_MUTEX_HPP
+#define LIBTHREADAR_SPIN_MUTEX_HPP
+
+    /// \file spin_mutex.hpp
+    /// \brief defines the spin_mutex class, a busy waiting test-and-test-and-set lock
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+
+    // libthreadar headers
+
+namespace libthreadar
+{
+
+	/// Class spin_mutex is a lock that never suspends the caller in the kernel
+
+	/// It has the same lock(), unlock() and try_lock() methods as libthreadar::mutex.
+	/// A thread calling lock() while the mutex is held polls it, reading it without
+	/// writing to it, so the waiting threads do not bounce its cache line between CPUs.
+	/// After a short time of polling, the waiting thread yields the CPU at each round.
+	///
+	/// spin_mutex is intended for critical sections of a few instructions (statistics
+	/// update, index increment...) under which suspending a thread would cost more than
+	/// the critical section itself. It is not fair: a thread may be overtaken by others
+	/// repeatedly, see ticket_mutex or mcs_mutex for fair alternatives.
+	///
+	/// \note there is no error checking: unlocking a spin_mutex not locked or locking it twice
+	/// from the same thread is undefined behavior
+    class spin_mutex
+    {
+    public:
+	    /// constructor
+	spin_mutex(): held(false) {};
+
+	    /// no copy constructor
+	spin_mutex(const spin_mutex & ref) = delete;
+
+	    /// no move constructor
+	spin_mutex(spin_mutex && ref) = delete;
+
+	    /// no assignment operator
+	spin_mutex & operator = (const spin_mutex & ref) = delete;
+
+	    /// no move operator
+	spin_mutex & operator = (spin_mutex && ref) = delete;
+
+	    /// destructor
+	~spin_mutex() = default;
+
+	    /// lock the mutex, busy waiting if another thread holds it
+	void lock() { if(held.exchange(true, std::memory_order_acquire)) lock_contended(); };
+
+	    /// unlock the mutex
+	void unlock() { held.store(false, std::memory_order_release); };
+
+	    /// acquire the mutex if available without waiting
+
+	    /// \return true if lock is acquired false if mutex was already locked
+	bool try_lock() { return ! held.load(std::memory_order_relaxed) && ! held.exchange(true, std::memory_order_acquire); };
+
+    private:
+	std::atomic<bool> held;  ///< whether the mutex is locked
+
+	void lock_contended();
+    };
+
+} // end of namespace
+
+#endif
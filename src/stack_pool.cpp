@@ -0,0 +1,302 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+}
+    // C++ standard headers
+#include <map>
+#include <vector>
+#include <new>
+
+    // libthreadar headers
+#include "mutex.hpp"
+
+    // this module's header
+#include "stack_pool.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+#if HAVE_MMAP && HAVE_MPROTECT && HAVE_SYS_MMAN_H
+#define STACK_POOL_USE_MMAP 1
+#else
+#define STACK_POOL_USE_MMAP 0
+#endif
+
+    namespace
+    {
+	struct pool_state
+	{
+	    mutex control;                               ///< protects the fields below
+	    map<unsigned int, vector<char *> > released; ///< released stacks per usable size
+	    unsigned int max_cached;                     ///< maximum number of stacks kept per size
+	    unsigned int cached;                         ///< total number of stacks kept
+
+	    pool_state() { max_cached = 64; cached = 0; };
+	};
+
+	    // built at first use, thus never before a thread needs a stack
+
+	pool_state & pool()
+	{
+	    static pool_state *ptr = new pool_state();
+
+		// never destroyed: threads may still release their stack
+		// while static objects are destroyed at process end
+	    return *ptr;
+	}
+    }
+
+    char *stack_pool::acquire(unsigned int size)
+    {
+	pool_state & st = pool();
+	unsigned int usable = usable_size(size);
+	char *ret = nullptr;
+
+	st.control.lock();
+	try
+	{
+	    map<unsigned int, vector<char *> >::iterator it = st.released.find(usable);
+
+	    if(it != st.released.end() && ! it->second.empty())
+	    {
+		ret = it->second.back();
+		it->second.pop_back();
+		--st.cached;
+	    }
+	}
+	catch(...)
+	{
+	    st.control.unlock();
+	    throw;
+	}
+	st.control.unlock();
+
+	if(ret == nullptr)
+	    ret = allocate(usable);
+
+	return ret;
+    }
+
+    void stack_pool::release(char *stack, unsigned int size)
+    {
+	pool_state & st = pool();
+	unsigned int usable = usable_size(size);
+	bool kept = false;
+
+	if(stack == nullptr)
+	    throw THREADAR_BUG;
+
+	st.control.lock();
+	try
+	{
+	    vector<char *> & avail = st.released[usable];
+
+	    if(avail.size() < st.max_cached)
+	    {
+		avail.push_back(stack);
+		++st.cached;
+		kept = true;
+	    }
+	}
+	catch(...)
+	{
+	    st.control.unlock();
+	    throw;
+	}
+	st.control.unlock();
+
+	if(! kept)
+	    deallocate(stack, usable);
+    }
+
+    unsigned int stack_pool::usable_size(unsigned int size)
+    {
+	unsigned int page = page_size();
+
+	if(size == 0)
+	    throw exception_range("zero byte stack requested");
+	if(size > ~0u - page)
+	    throw exception_range("stack size too large");
+
+	return ((size + page - 1) / page) * page;
+    }
+
+    void stack_pool::set_max_cached(unsigned int num)
+    {
+	pool_state & st = pool();
+	vector<pair<char *, unsigned int> > to_free;
+
+	st.control.lock();
+	try
+	{
+	    st.max_cached = num;
+	    for(map<unsigned int, vector<char *> >::iterator it = st.released.begin(); it != st.released.end(); ++it)
+	    {
+		while(it->second.size() > num)
+		{
+		    to_free.push_back(make_pair(it->second.back(), it->first));
+		    it->second.pop_back();
+		    --st.cached;
+		}
+	    }
+	}
+	catch(...)
+	{
+	    st.control.unlock();
+	    throw;
+	}
+	st.control.unlock();
+
+	for(vector<pair<char *, unsigned int> >::iterator it = to_free.begin(); it != to_free.end(); ++it)
+	    deallocate(it->first, it->second);
+    }
+
+    unsigned int stack_pool::get_max_cached()
+    {
+	pool_state & st = pool();
+	unsigned int ret;
+
+	st.control.lock();
+	ret = st.max_cached;
+	st.control.unlock();
+
+	return ret;
+    }
+
+    unsigned int stack_pool::get_cached()
+    {
+	pool_state & st = pool();
+	unsigned int ret;
+
+	st.control.lock();
+	ret = st.cached;
+	st.control.unlock();
+
+	return ret;
+    }
+
+    void stack_pool::clear()
+    {
+	pool_state & st = pool();
+	map<unsigned int, vector<char *> > to_free;
+
+	st.control.lock();
+	try
+	{
+	    to_free.swap(st.released);
+	    st.cached = 0;
+	}
+	catch(...)
+	{
+	    st.control.unlock();
+	    throw;
+	}
+	st.control.unlock();
+
+	for(map<unsigned int, vector<char *> >::iterator it = to_free.begin(); it != to_free.end(); ++it)
+	    for(vector<char *>::iterator sit = it->second.begin(); sit != it->second.end(); ++sit)
+		deallocate(*sit, it->first);
+    }
+
+    char *stack_pool::allocate(unsigned int size)
+    {
+#if STACK_POOL_USE_MMAP
+	unsigned int page = page_size();
+	char *base = reinterpret_cast<char *>(mmap(nullptr,
+						  size + page,
+						  PROT_READ|PROT_WRITE,
+						  MAP_PRIVATE|MAP_ANONYMOUS
+#ifdef MAP_STACK
+						  |MAP_STACK
+#endif
+						  ,
+						  -1,
+						  0));
+	if(base == MAP_FAILED)
+	{
+	    if(errno == ENOMEM)
+		throw exception_memory();
+	    else
+		throw exception_system("Failed mapping memory for a thread stack: ", errno);
+	}
+
+	    // stacks grow downward, the guard page is the lowest one
+	if(mprotect(base, page, PROT_NONE) != 0)
+	{
+	    int err = errno;
+	    (void)munmap(base, size + page);
+	    throw exception_system("Failed setting guard page of a thread stack: ", err);
+	}
+
+	return base + page;
+#else
+	char *ret = new (nothrow) char[size];
+
+	if(ret == nullptr)
+	    throw exception_memory();
+
+	return ret;
+#endif
+    }
+
+    void stack_pool::deallocate(char *stack, unsigned int size)
+    {
+#if STACK_POOL_USE_MMAP
+	unsigned int page = page_size();
+
+	    // munmap() can only fail here on invalid arguments, nothing can be
+	    // done about it and this is called from thread's destructor
+	(void)munmap(stack - page, size + page);
+#else
+	delete [] stack;
+#endif
+    }
+
+    unsigned int stack_pool::page_size()
+    {
+#if HAVE_UNISTD_H
+	static const long val = sysconf(_SC_PAGESIZE);
+
+	return val > 0 ? (unsigned int)val : 4096;
+#else
+	return 4096;
+#endif
+    }
+
+} // end of namespace
@@ -0,0 +1,103 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef LIBTHREADAR_STACK_POOL_HPP
+#define LIBTHREADAR_STACK_POOL_HPP
+
+    /// \file stack_pool.hpp
+    /// \brief defines the stack_pool class that provides and recycles thread stacks
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+
+    // libthreadar headers
+#include "exceptions.hpp"
+
+namespace libthreadar
+{
+
+	/// Class stack_pool provides the stacks used by thread::set_stack_size()
+
+	/// Each stack is mapped with mmap(), is page aligned and its size is rounded up
+	/// to a multiple of the page size. A guard page without any access right is placed
+	/// just below the stack, so a stack overflow generates a segmentation fault instead
+	/// of silently corrupting the memory located next to the stack.
+	///
+	/// Released stacks are kept in a process-wide pool per stack size, up to a limit
+	/// per size, and provided again to the next thread asking the same stack size, so
+	/// running many short-lived threads with a custom stack avoids both the memory
+	/// allocator and the mmap()/munmap() system calls.
+	///
+	/// \note on systems without mmap() stacks are allocated from the heap, without guard page
+	/// \note all methods are static and thread-safe
+
+    class stack_pool
+    {
+    public:
+	stack_pool() = delete;
+
+	    /// obtain a stack
+
+	    /// \param[in] size requested size of the stack in bytes
+	    /// \return the lowest address of a stack of at least usable_size(size) bytes
+	static char *acquire(unsigned int size);
+
+	    /// give back a stack obtained by acquire()
+
+	    /// \param[in] stack the address returned by acquire()
+	    /// \param[in] size the argument given to acquire()
+	    /// \note the stack must no more be used by any thread
+	static void release(char *stack, unsigned int size);
+
+	    /// the size really available for a stack requested with the given size
+	static unsigned int usable_size(unsigned int size);
+
+	    /// set the maximum number of released stacks kept in the pool for each size (default is 64)
+
+	    /// \note stacks above this number are unmapped at once when released, setting zero
+	    /// disables the recycling
+	static void set_max_cached(unsigned int num);
+
+	    /// get the maximum number of released stacks kept in the pool for each size
+	static unsigned int get_max_cached();
+
+	    /// number of released stacks currently kept in the pool
+	static unsigned int get_cached();
+
+	    /// unmap all the stacks kept in the pool
+	static void clear();
+
+    private:
+	static char *allocate(unsigned int size);
+	static void deallocate(char *stack, unsigned int size);
+	static unsigned int page_size();
+    };
+
+} // end of namespace
+
+#endif
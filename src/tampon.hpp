@@ -38,7 +38,8 @@ extern "C"
 
 
     // libthreadar headers
-#include "mutex.hpp"
+#include "condition.hpp"
+#include "lock_guard.hpp"
 #include "exceptions.hpp"
 
 namespace libthreadar
@@ -132,6 +133,9 @@ namespace libthreadar
 	    /// \note note that the caller shall never release the address pointed to by ptr
 	void get_block_to_feed(T * & ptr, unsigned int & num);
 
+	    /// same as get_block_to_feed() but aborts with thread::cancel_except if the token is cancelled while waiting for a free block
+	void get_block_to_feed(T * & ptr, unsigned int & num, const cancellation_token & token);
+
 	    /// feeder call - step 2
 
 	    /// Once data has been copied into the block obtained by a call to get_block_to_feed(), use this call to given back this block to the tampon object
@@ -154,6 +158,9 @@ namespace libthreadar
 	    /// \note that the caller shall never release the address pointed to by ptr
 	void fetch(T* & ptr, unsigned int & num);
 
+	    /// same as fetch() but aborts with thread::cancel_except if the token is cancelled while waiting for a block to read
+	void fetch(T* & ptr, unsigned int & num, const cancellation_token & token);
+
 	    /// fetcher call - step 2
 
 	    /// Once data has been read, the fetcher must recycle the block into the tampon object
@@ -191,7 +198,7 @@ namespace libthreadar
 	bool is_not_empty() const { return !is_empty(); };
 
 	    /// for feeder to know whether the next call to get_block_to_feed() will be blocking
-	bool is_full() const { return full; }; // no need to acquire mutex "modif"
+	bool is_full() const { return full; }; // no need to acquire the lock "modif"
 
 	    /// to know whether the tampon is *not* full
 	bool is_not_full() const { return !is_full(); };
@@ -225,7 +232,10 @@ namespace libthreadar
 	    atom() { mem = nullptr; data_size = 0; };
 	};
 
-	mutex modif;              //< to make critical section when non atomic action requires a status has not changed between a test and following action
+	static const unsigned int cond_full = 0;  //< condition the feeder waits on when the table is full
+	static const unsigned int cond_empty = 1; //< condition the fetcher waits on when no block is readable
+
+	condition modif;          //< to make critical section when non atomic action requires a status has not changed between a test and following action
 	atom *table;              //< datastructure holding data in transit between two threads
 	unsigned int table_size;  //< size of table, i.e. number of struct atom it holds
 	unsigned int alloc_size;  //< size of allocated memory for each atom in table
@@ -234,13 +244,7 @@ namespace libthreadar
 	unsigned int fetch_head;  //< the oldest object to be fetched
 	bool fetch_outside;       //< if set to true, table's index pointed to by next_fetch is used by the fetcher
 	bool feed_outside;        //< if set to true, table's index pointed to by next_feed is used by the feeder
-	mutex waiting_feeder;     //< feeder thread may be stuck waiting on that semaphore if table is full
-	mutex waiting_fetcher;    //< fetcher thread may be stuck waiting on that semaphore if table is empty
 	bool full;                //< set when tampon is full
-	bool feeder_go_lock;      //< true to inform fetcher than feeder is about to or has already acquire lock on waiting_feeder
-	bool feeder_lock_track;   //< only used by feeder to lock on waiting_feeder once outside of critical section
-	bool fetcher_go_lock;     //< true to inform feeder than fetcher is about to or has already acquire lock on waiting_fetcher
-	bool fetcher_lock_track;  //< only used by fetcher to lock on waiting_fetcher once outside of critical section
 
 	bool is_empty_no_lock() const { return next_feed == fetch_head && !full; };
 
@@ -259,9 +263,15 @@ namespace libthreadar
 	    /// \param[in] end is the first slot that will *not* be copied to the previous slot (cyclicly)
 	void shift_by_one_data_in_range(unsigned int begin, unsigned int end);
 
+	    /// implementation of get_block_to_feed(), token being nullptr when none was given
+	void get_block_to_feed_with(T * & ptr, unsigned int & num, const cancellation_token *token);
+
+	    /// implementation of fetch(), token being nullptr when none was given
+	void fetch_with(T* & ptr, unsigned int & num, const cancellation_token *token);
+
     };
 
-    template <class T> tampon<T>::tampon(unsigned int max_block, unsigned int block_size)
+    template <class T> tampon<T>::tampon(unsigned int max_block, unsigned int block_size): modif(2)
     {
 	table_size = max_block;
 	table = new atom[table_size];
@@ -315,24 +325,31 @@ namespace libthreadar
     }
 
     template <class T> void tampon<T>::get_block_to_feed(T * & ptr, unsigned int & num)
+    {
+	get_block_to_feed_with(ptr, num, nullptr);
+    }
+
+    template <class T> void tampon<T>::get_block_to_feed(T * & ptr, unsigned int & num, const cancellation_token & token)
+    {
+	get_block_to_feed_with(ptr, num, &token);
+    }
+
+    template <class T> void tampon<T>::get_block_to_feed_with(T * & ptr, unsigned int & num, const cancellation_token *token)
     {
 	if(feed_outside)
 	    throw exception_range("feed already out!");
 
-	modif.lock();  	// --- critical section START
-	if(is_full())
 	{
-	    feeder_go_lock = true;   // inform fetcher that we will suspend in waiting_feeder
-	    feeder_lock_track = true;// to suspend on waiting_feeder once we will be out of the critical section
-	}
-	modif.unlock(); // --- critical section END
+	    lock_guard<condition> lock(modif);  // --- critical section up to end of block
+	    auto not_full = [this]() { return ! full; };
 
-	if(feeder_lock_track)
-	{
-	    feeder_lock_track = false;
-	    waiting_feeder.lock(); // cannot lock inside a critical section ...
+	    if(token != nullptr)
+		modif.wait(cond_full, not_full, *token);
+	    else
+		modif.wait(cond_full, not_full);
 	}
 
+	    // only the feeder (this is us) can fill the table again
 	if(is_full())
 	    throw THREADAR_BUG; // still full!
 
@@ -351,16 +368,12 @@ namespace libthreadar
 	    throw exception_range("returned ptr is not the one given earlier for feeding");
 	table[next_feed].data_size = num;
 
-	modif.lock();   // --- critical section START
+	lock_guard<condition> lock(modif);  // --- critical section up to end of block
 	shift_by_one(next_feed);
 	if(next_feed == fetch_head)
 	    full = true;
-	if(fetcher_go_lock)
-	{
-	    fetcher_go_lock = false;
-	    waiting_fetcher.unlock();
-	}
-	modif.unlock(); // --- critical section END
+	if(modif.get_waiting_thread_count(cond_empty) > 0)
+	    modif.signal(cond_empty);
     }
 
     template <class T> void tampon<T>::feed_cancel_get_block(T *ptr)
@@ -373,22 +386,28 @@ namespace libthreadar
     }
 
     template <class T> void tampon<T>::fetch(T* & ptr, unsigned int & num)
+    {
+	fetch_with(ptr, num, nullptr);
+    }
+
+    template <class T> void tampon<T>::fetch(T* & ptr, unsigned int & num, const cancellation_token & token)
+    {
+	fetch_with(ptr, num, &token);
+    }
+
+    template <class T> void tampon<T>::fetch_with(T* & ptr, unsigned int & num, const cancellation_token *token)
     {
 	if(fetch_outside)
 	    throw exception_range("already fetched block outside");
 
-	modif.lock();   // --- critical section START
-	if(!has_readable_block_next_no_lock())
 	{
-	    fetcher_go_lock = true;    // to inform feeder that we will suspend on waiting_fetcher
-	    fetcher_lock_track = true; // to suspend on waiting_fetcher once we will be out of the critical section
-	}
-	modif.unlock(); // --- critical section END
+	    lock_guard<condition> lock(modif);  // --- critical section up to end of block
+	    auto readable = [this]() { return has_readable_block_next_no_lock(); };
 
-	if(fetcher_lock_track)
-	{
-	    fetcher_lock_track = false;
-	    waiting_fetcher.lock();   // cannot lock inside a critical section ...
+	    if(token != nullptr)
+		modif.wait(cond_empty, readable, *token);
+	    else
+		modif.wait(cond_empty, readable);
 	}
 
 	if(is_empty())
@@ -407,7 +426,7 @@ namespace libthreadar
 	if(ptr != table[next_fetch].mem)
 	    throw exception_range("returned ptr is no the one given earlier for fetching");
 
-	modif.lock();   // --- critical section START
+	lock_guard<condition> lock(modif);  // --- critical section up to end of block
 	if(next_fetch == fetch_head)
 	{
 
@@ -441,12 +460,8 @@ namespace libthreadar
 	    full = false;
 	}
 
-	if(feeder_go_lock)
-	{
-	    feeder_go_lock = false;
-	    waiting_feeder.unlock();
-	}
-	modif.unlock(); // --- critical section END
+	if(modif.get_waiting_thread_count(cond_full) > 0)
+	    modif.signal(cond_full);
     }
 
     template <class T> void tampon<T>::fetch_push_back(T* ptr, unsigned int new_num)
@@ -464,11 +479,11 @@ namespace libthreadar
 								unsigned int new_num)
     {
 	fetch_push_back(ptr, new_num);
-      	modif.lock();   // --- critical section START
+
+	lock_guard<condition> lock(modif);  // --- critical section up to end of block
 	if(full && next_fetch == next_feed) // reach last block feed, cannot skip it
 	    throw exception_range("cannot skip the last fed block when the tampon is full");
 	shift_by_one(next_fetch);
-	modif.unlock(); // --- critical section END
     }
 
     template <class T> void tampon<T>::fetch_skip_back()
@@ -486,9 +501,8 @@ namespace libthreadar
 	tampon<T> *me = const_cast<tampon<T> *>(this);
 	if(me == nullptr)
 	    throw THREADAR_BUG;
-	me->modif.lock();
+	lock_guard<condition> lock(me->modif);
 	ret = has_readable_block_next_no_lock();
-	me->modif.unlock();
 
 	return ret;
     }
@@ -501,9 +515,8 @@ namespace libthreadar
 	tampon<T> * me = const_cast<tampon<T> *>(this);
 	if(me == nullptr)
 	    throw THREADAR_BUG;
-	me->modif.lock();
+	lock_guard<condition> lock(me->modif);
 	ret = is_empty_no_lock();
-	me->modif.unlock();
 
 	return ret;
     }
@@ -516,12 +529,6 @@ namespace libthreadar
 	fetch_outside = false;
 	feed_outside = false;
 	full = false;
-	feeder_go_lock = false;
-	feeder_lock_track = false;
-	fetcher_go_lock = false;
-	fetcher_lock_track = false;
-	(void)waiting_feeder.try_lock();
-	(void)waiting_fetcher.try_lock();
     }
 
     template <class T> void tampon<T>::shift_by_one(unsigned int & x) const
@@ -0,0 +1,333 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <new>
+
+    // libthreadar headers
+#include "tools.hpp"
+#include "parallel_for.hpp"
+
+    // this module's header
+#include "task_graph.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+    task_graph::task_id task_graph::add_task(const function<void()> & fn,
+					     const vector<task_id> & predecessors,
+					     unsigned int cost)
+    {
+	node n;
+	task_id ret = nodes.size();
+
+	if(in_run)
+	    throw exception_thread("cannot add a task to a task_graph while it is running");
+	if(! fn)
+	    throw exception_range("cannot add an empty task to a task_graph");
+
+	for(vector<task_id>::const_iterator it = predecessors.begin(); it != predecessors.end(); ++it)
+	    if(*it >= ret)
+		throw exception_range(string("unknown predecessor task ") + tools_convert_to_string(*it));
+
+	n.fn = fn;
+	n.predecessors = 0;
+	n.cost = cost;
+	n.priority = 0;
+	nodes.push_back(n);
+
+	for(vector<task_id>::const_iterator it = predecessors.begin(); it != predecessors.end(); ++it)
+	    add_dependency(*it, ret);
+
+	return ret;
+    }
+
+    void task_graph::add_dependency(task_id before, task_id after)
+    {
+	if(in_run)
+	    throw exception_thread("cannot add a dependency to a task_graph while it is running");
+	if(before >= nodes.size() || after >= nodes.size())
+	    throw exception_range("unknown task given to task_graph::add_dependency()");
+	if(before == after)
+	    throw exception_range("a task cannot depend on itself");
+
+	nodes[before].successors.push_back(after);
+	++nodes[after].predecessors;
+    }
+
+    void task_graph::clear()
+    {
+	if(in_run)
+	    throw exception_thread("cannot clear a task_graph while it is running");
+	nodes.clear();
+    }
+
+    void task_graph::run()
+    {
+	run(parallel_default_pool());
+    }
+
+    void task_graph::run(thread_pool & pool)
+    {
+	shared_ptr<run_state> rs;
+	unsigned int initial = 0;
+
+	if(in_run)
+	    throw exception_thread("task_graph is already running");
+	if(nodes.empty())
+	    return;
+
+	compute_priorities();
+
+	rs.reset(new (nothrow) run_state());
+	if(! rs)
+	    throw exception_memory();
+
+	rs->pool = &pool;
+	rs->nodes = &nodes;
+	rs->pending.resize(nodes.size());
+	rs->running = 0;
+	rs->completed = 0;
+	rs->failed = false;
+
+	for(task_id i = 0; i < nodes.size(); ++i)
+	{
+	    rs->pending[i] = nodes[i].predecessors;
+	    if(rs->pending[i] == 0)
+	    {
+		rs->ready.push(make_pair(nodes[i].priority, i));
+		++initial;
+	    }
+	}
+
+	in_run = true;
+	try
+	{
+		// we take one of the ready tasks ourself
+	    submit_runners(rs, initial - 1);
+
+	    while(true)
+	    {
+		if(! execute_one(rs))
+		{
+		    bool finished;
+
+		    rs->verrou.lock();
+		    try
+		    {
+			while(rs->ready.empty() && ! rs->finished())
+			    rs->verrou.wait();
+			finished = rs->finished();
+		    }
+		    catch(...)
+		    {
+			rs->verrou.unlock();
+			throw;
+		    }
+		    rs->verrou.unlock();
+
+		    if(finished)
+			break;
+		}
+	    }
+	}
+	catch(...)
+	{
+		// no more task will start, waiting for the running ones
+		// as they refer to our nodes, this waiting must not be
+		// interrupted even if we are being cancelled
+	    cancellation_token not_cancelled;
+	    cancellation_token::scope masked(not_cancelled);
+
+	    rs->verrou.lock();
+	    rs->failed = true;
+	    while(! rs->ready.empty())
+		rs->ready.pop();
+	    while(rs->running > 0)
+		rs->verrou.wait();
+	    rs->verrou.unlock();
+
+	    in_run = false;
+	    throw;
+	}
+	in_run = false;
+
+	if(rs->except)
+	    rethrow_exception(rs->except);
+    }
+
+    void task_graph::compute_priorities()
+    {
+	vector<unsigned int> remaining(nodes.size());
+	vector<task_id> order;
+	vector<task_id> todo;
+
+	    // topological order (Kahn's algorithm), also detecting cycles
+
+	order.reserve(nodes.size());
+	for(task_id i = 0; i < nodes.size(); ++i)
+	{
+	    remaining[i] = nodes[i].predecessors;
+	    if(remaining[i] == 0)
+		todo.push_back(i);
+	}
+
+	while(! todo.empty())
+	{
+	    task_id cur = todo.back();
+
+	    todo.pop_back();
+	    order.push_back(cur);
+	    for(vector<task_id>::iterator it = nodes[cur].successors.begin(); it != nodes[cur].successors.end(); ++it)
+		if(--remaining[*it] == 0)
+		    todo.push_back(*it);
+	}
+
+	if(order.size() != nodes.size())
+	    throw exception_range("the dependencies of the task_graph contain a cycle");
+
+	    // longest path to the end of the graph, computed in reverse topological order
+
+	for(vector<task_id>::reverse_iterator it = order.rbegin(); it != order.rend(); ++it)
+	{
+	    node & cur = nodes[*it];
+	    unsigned long long longest = 0;
+
+	    for(vector<task_id>::iterator sit = cur.successors.begin(); sit != cur.successors.end(); ++sit)
+		if(nodes[*sit].priority > longest)
+		    longest = nodes[*sit].priority;
+
+	    cur.priority = longest + cur.cost;
+	}
+    }
+
+    bool task_graph::execute_one(const shared_ptr<run_state> & rs)
+    {
+	task_id id;
+	exception_ptr except;
+	unsigned int newly_ready = 0;
+
+	rs->verrou.lock();
+	try
+	{
+	    if(rs->failed || rs->ready.empty())
+	    {
+		rs->verrou.unlock();
+		return false;
+	    }
+
+	    id = rs->ready.top().second;
+	    rs->ready.pop();
+	    ++rs->running;
+	}
+	catch(...)
+	{
+	    rs->verrou.unlock();
+	    throw;
+	}
+	rs->verrou.unlock();
+
+	try
+	{
+	    (*rs->nodes)[id].fn();
+	}
+	catch(...)
+	{
+	    except = current_exception();
+	}
+
+	rs->verrou.lock();
+	try
+	{
+	    const node & done = (*rs->nodes)[id];
+
+	    --rs->running;
+	    if(except)
+	    {
+		if(! rs->failed)
+		{
+		    rs->failed = true;
+		    rs->except = except;
+		}
+		while(! rs->ready.empty())
+		    rs->ready.pop();
+	    }
+	    else
+	    {
+		++rs->completed;
+		if(! rs->failed)
+		{
+		    for(vector<task_id>::const_iterator it = done.successors.begin(); it != done.successors.end(); ++it)
+		    {
+			if(--rs->pending[*it] == 0)
+			{
+			    rs->ready.push(make_pair((*rs->nodes)[*it].priority, *it));
+			    ++newly_ready;
+			}
+		    }
+		}
+	    }
+
+	    if(rs->verrou.get_waiting_thread_count() > 0
+	       && (newly_ready > 0 || rs->finished()))
+		rs->verrou.broadcast();
+	}
+	catch(...)
+	{
+	    rs->verrou.unlock();
+	    throw;
+	}
+	rs->verrou.unlock();
+
+	    // this thread will itself run one of the newly ready tasks
+	if(newly_ready > 1)
+	    submit_runners(rs, newly_ready - 1);
+
+	return true;
+    }
+
+    void task_graph::submit_runners(const shared_ptr<run_state> & rs, unsigned int num)
+    {
+	    // each runner executes the ready task of highest priority at the
+	    // time it starts, not a particular task, if no task is ready at that
+	    // time (they have been taken by other threads) it does nothing
+	for(unsigned int i = 0; i < num; ++i)
+	{
+	    shared_ptr<run_state> ref = rs;
+	    rs->pool->submit([ref]()
+			     {
+				 while(execute_one(ref))
+				     ; // going on as long as tasks are ready
+			     });
+	}
+    }
+
+} // end of namespace
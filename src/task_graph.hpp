@@ -0,0 +1,174 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef LIBTHREADAR_TASK_GRAPH_HPP
+#define LIBTHREADAR_TASK_GRAPH_HPP
+
+    /// \file task_graph.hpp
+    /// \brief defines the task_graph class that runs tasks with dependencies over a thread_pool
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <vector>
+#include <queue>
+#include <memory>
+#include <functional>
+#include <exception>
+
+    // libthreadar headers
+#include "exceptions.hpp"
+#include "condition.hpp"
+#include "thread_pool.hpp"
+
+namespace libthreadar
+{
+
+	/// Class task_graph runs a set of tasks that depend on each other
+
+	/// Tasks are added with add_task() giving the tasks they depend on (their predecessors),
+	/// which must have been added before, or later with add_dependency(). run() then executes
+	/// all the tasks over the workers of a thread_pool, the calling thread taking part to the
+	/// work: each task has a counter of predecessors not yet completed and becomes ready when
+	/// this counter reaches zero.
+	///
+	/// Among ready tasks, the one with the longest path (sum of task costs) to the end of
+	/// the graph runs first (critical path first), so the tasks that delay the whole graph
+	/// the most start as soon as possible. The cost of a task is given by add_task(), it
+	/// defaults to one, in which case the longest path is counted in number of tasks.
+	///
+	/// If a task throws an exception, no new task is started, run() waits for the running
+	/// tasks to complete and rethrows the first exception, the same way thread::join() does
+	/// for an exception thrown from inherited_run().
+	///
+	/// \note the graph can be run several times, but not concurrently.
+
+    class task_graph
+    {
+    public:
+	    /// identifier of a task in the graph
+	typedef unsigned int task_id;
+
+	    /// constructor
+	task_graph(): in_run(false) {};
+
+	    /// no copy constructor
+	task_graph(const task_graph & ref) = delete;
+
+	    /// no move constructor
+	task_graph(task_graph && ref) = delete;
+
+	    /// no assignment operator
+	task_graph & operator = (const task_graph & ref) = delete;
+
+	    /// no move operator
+	task_graph & operator = (task_graph && ref) = delete;
+
+	    /// destructor
+	~task_graph() = default;
+
+	    /// add a task to the graph
+
+	    /// \param[in] fn the task to run
+	    /// \param[in] predecessors tasks that must complete before this one starts
+	    /// \param[in] cost estimation of the task duration in any unit, used for prioritization
+	    /// \return the identifier of the new task
+	task_id add_task(const std::function<void()> & fn,
+			 const std::vector<task_id> & predecessors = std::vector<task_id>(),
+			 unsigned int cost = 1);
+
+	    /// add a dependency between two existing tasks
+
+	    /// \param[in] before task that must complete before the other starts
+	    /// \param[in] after task that depends on the former
+	void add_dependency(task_id before, task_id after);
+
+	    /// number of tasks in the graph
+	unsigned int size() const { return nodes.size(); };
+
+	    /// remove all tasks from the graph
+	void clear();
+
+	    /// run all the tasks and wait for their completion
+
+	    /// \param[in] pool the thread_pool whose workers run the tasks
+	    /// \note throws exception_range if the dependencies contain a cycle
+	    /// \note rethrows the first exception thrown by a task
+	void run(thread_pool & pool);
+
+	    /// run all the tasks using the parallel_default_pool()
+	void run();
+
+    private:
+	struct node
+	{
+	    std::function<void()> fn;      ///< the task
+	    std::vector<task_id> successors; ///< tasks depending on this one
+	    unsigned int predecessors;     ///< number of tasks this one depends on
+	    unsigned int cost;             ///< estimated duration
+	    unsigned long long priority;   ///< longest path cost from this task to the end of the graph
+	};
+
+	typedef std::pair<unsigned long long, task_id> ready_entry;
+
+	struct ready_order
+	{
+	    bool operator () (const ready_entry & a, const ready_entry & b) const
+	    {
+		    // higher priority first, then the first added task
+		return a.first < b.first || (a.first == b.first && a.second > b.second);
+	    };
+	};
+
+	    /// state of a run() execution, shared with the tasks submitted to the pool
+	struct run_state
+	{
+	    thread_pool *pool;
+	    const std::vector<node> *nodes;
+	    std::vector<unsigned int> pending; ///< predecessors not yet completed per task
+	    std::priority_queue<ready_entry, std::vector<ready_entry>, ready_order> ready;
+	    unsigned int running;              ///< tasks being executed
+	    unsigned int completed;            ///< tasks completed
+	    bool failed;                       ///< whether a task has thrown an exception
+	    std::exception_ptr except;         ///< first exception thrown by a task
+	    condition verrou;                  ///< protects the fields above
+
+	    bool finished() const { return completed == nodes->size() || (failed && running == 0); };
+	};
+
+	std::vector<node> nodes;
+	bool in_run;                   ///< whether run() is being executed
+
+	void compute_priorities();
+
+	static bool execute_one(const std::shared_ptr<run_state> & rs);
+	static void submit_runners(const std::shared_ptr<run_state> & rs, unsigned int num);
+    };
+
+} // end of namespace
+
+#endif
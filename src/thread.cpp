@@ -32,13 +32,35 @@ extern "C"
 #if HAVE_STRING_H
 #include <string.h>
 #endif
+#if HAVE_SCHED_H
+#include <sched.h>
+#endif
+#if HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+#if HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_TIME_H
+#include <time.h>
+#endif
+#if HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
 }
     // C++ standard headers
+#include <fstream>
+#include <sstream>
 
 
     // libthreadar headers
 #include "exceptions.hpp"
 #include "tools.hpp"
+#include "cpu_topology.hpp"
+#include "stack_pool.hpp"
 
     // this module's header
 #include "thread.hpp"
@@ -49,13 +71,36 @@ using namespace std;
 namespace libthreadar
 {
 
+    static int native_policy(thread::sched_policy policy);
+    static bool nice_applies(thread::sched_policy policy);
+
+    namespace
+    {
+	struct registry
+	{
+	    mutex control;           ///< protects the field below
+	    set<thread *> live;      ///< threads between the start of run_obj() and their end
+	};
+
+	registry & live_registry()
+	{
+	    static registry *ptr = new registry();
+
+		// never destroyed: detached threads may still
+		// end while static objects are destroyed
+	    return *ptr;
+	}
+    }
+
     thread::thread()
     {
 	running = false;
 	joignable = false;
-	do_cancel = false;
 	stack_size = 0;
 	stack = nullptr;
+	sched = sched_policy::inherit;
+	sched_prio = 0;
+	kernel_tid = 0;
 	sigemptyset(&sigmask);
     }
 
@@ -72,7 +117,15 @@ namespace libthreadar
 		// such exceptions should have been generated earlier using join() if
 		// it had any importance to be taken care of
 	}
-	clear_stack();
+
+	try
+	{
+	    clear_stack();
+	}
+	catch(...)
+	{
+		// the stack is lost but a destructor should not generate exceptions
+	}
     }
 
     void thread::reset_stack_size()
@@ -82,6 +135,8 @@ namespace libthreadar
 	{
 	    if(running)
 		throw exception_thread("Cannot change stack size while the thread is running");
+	    if(joignable)
+		throw exception_thread("Cannot change stack size before the previous thread has been joined");
 
 	    clear_stack();
 	    stack_size = 0;
@@ -101,16 +156,13 @@ namespace libthreadar
 	{
 	    if(running)
 		throw exception_thread("Cannot change stack size while the thread is running");
+	    if(joignable)
+		throw exception_thread("Cannot change stack size before the previous thread has been joined");
 
 	    clear_stack();
-	    stack = new (nothrow) char[val];
-	    if(stack == nullptr)
-	    {
-		stack_size = 0;
-		throw exception_memory();
-	    }
-	    else
-		stack_size = val;
+	    stack_size = 0;
+	    stack = stack_pool::acquire(val);
+	    stack_size = val;
 	}
 	catch(...)
 	{
@@ -120,6 +172,99 @@ namespace libthreadar
 	field_control.unlock();
     }
 
+    void thread::set_cpu_affinity(const set<unsigned int> & cpus)
+    {
+	field_control.lock();
+	try
+	{
+	    if(running)
+		throw exception_thread("Cannot change CPU affinity while the thread is running");
+
+#if HAVE_PTHREAD_ATTR_SETAFFINITY_NP
+	    for(set<unsigned int>::const_iterator it = cpus.begin(); it != cpus.end(); ++it)
+		if(*it >= CPU_SETSIZE)
+		    throw exception_range(string("CPU number too large: ") + tools_convert_to_string(*it));
+#endif
+	    affinity = cpus;
+	}
+	catch(...)
+	{
+	    field_control.unlock();
+	    throw;
+	}
+	field_control.unlock();
+    }
+
+    void thread::set_numa_node(unsigned int node)
+    {
+	set_cpu_affinity(cpu_topology::node_cpus(node));
+    }
+
+    void thread::reset_cpu_affinity()
+    {
+	set_cpu_affinity(set<unsigned int>());
+    }
+
+    set<unsigned int> thread::get_cpu_affinity() const
+    {
+	set<unsigned int> ret;
+
+	field_control.lock();
+	try
+	{
+	    ret = affinity;
+	}
+	catch(...)
+	{
+	    field_control.unlock();
+	    throw;
+	}
+	field_control.unlock();
+
+	return ret;
+    }
+
+    void thread::set_scheduling(sched_policy policy, int priority)
+    {
+	switch(policy)
+	{
+	case sched_policy::inherit:
+	case sched_policy::idle:
+	    priority = 0;
+	    break;
+	case sched_policy::other:
+	case sched_policy::batch:
+	    if(priority < -20 || priority > 19)
+		throw exception_range(string("nice value out of range [-20,19]: ") + tools_convert_to_string(priority));
+	    break;
+	case sched_policy::fifo:
+	case sched_policy::rr:
+	    if(priority < sched_get_priority_min(native_policy(policy))
+	       || priority > sched_get_priority_max(native_policy(policy)))
+		throw exception_range(string("real-time priority out of range: ") + tools_convert_to_string(priority));
+	    break;
+	default:
+	    throw THREADAR_BUG;
+	}
+
+	(void)native_policy(policy); // throws exception_feature if the policy is not available
+
+	field_control.lock();
+	try
+	{
+	    if(running)
+		throw exception_thread("Cannot change scheduling while the thread is running");
+
+	    sched = policy;
+	    sched_prio = priority;
+	}
+	catch(...)
+	{
+	    field_control.unlock();
+	    throw;
+	}
+	field_control.unlock();
+    }
 
     void thread::run()
     {
@@ -157,7 +302,7 @@ namespace libthreadar
 
 		switch(pthread_attr_setstack(&thread_attribs,
 					     stack,
-					     stack_size))
+					     stack_pool::usable_size(stack_size)))
 		{
 		case 0:
 		    break;
@@ -173,12 +318,91 @@ namespace libthreadar
 		}
 	    }
 
+	    if(! affinity.empty())
+	    {
+#if HAVE_PTHREAD_ATTR_SETAFFINITY_NP
+		cpu_set_t cpus;
+
+		CPU_ZERO(&cpus);
+		for(set<unsigned int>::iterator it = affinity.begin(); it != affinity.end(); ++it)
+		    CPU_SET(*it, &cpus);
+
+		switch(pthread_attr_setaffinity_np(&thread_attribs, sizeof(cpus), &cpus))
+		{
+		case 0:
+		    break;
+		case EINVAL:
+		    throw exception_range("CPU affinity set contains no CPU available on this system");
+		case ENOMEM:
+		    throw exception_memory();
+		default:
+		    throw THREADAR_BUG;
+		}
+#else
+		throw exception_feature("CPU affinity");
+#endif
+	    }
+
+	    if(sched != sched_policy::inherit)
+	    {
+		struct sched_param param;
+		int policy = native_policy(sched);
+
+		    // pthread attributes only support SCHED_OTHER, SCHED_FIFO and SCHED_RR
+		    // the other policies are set by the new thread itself, see run_obj()
+		if(policy != SCHED_FIFO && policy != SCHED_RR)
+		{
+		    policy = SCHED_OTHER;
+		    param.sched_priority = 0;
+		}
+		else
+		    param.sched_priority = sched_prio;
+
+		if(pthread_attr_setinheritsched(&thread_attribs, PTHREAD_EXPLICIT_SCHED) != 0)
+		    throw exception_feature("explicit thread scheduling");
+
+		switch(pthread_attr_setschedpolicy(&thread_attribs, policy))
+		{
+		case 0:
+		    break;
+		case EINVAL:
+		case ENOTSUP:
+		    throw exception_feature("thread scheduling policy");
+		default:
+		    throw THREADAR_BUG;
+		}
+
+		switch(pthread_attr_setschedparam(&thread_attribs, &param))
+		{
+		case 0:
+		    break;
+		case EINVAL:
+		case ENOTSUP:
+		    throw exception_range(string("invalid scheduling priority: ") + tools_convert_to_string(sched_prio));
+		default:
+		    throw THREADAR_BUG;
+		}
+	    }
+
 
 		// thread creation
 
-	    do_cancel = false;
-	    if(pthread_create(&tid, &thread_attribs, run_obj, this) != 0)
-		throw exception_system("Failed creating a new thread: ", errno);
+	    cancel_token = cancellation_token();
+	    kernel_tid = 0;
+	    final_usage = cpu_usage();
+	    switch(int ret = pthread_create(&tid, &thread_attribs, run_obj, this))
+	    {
+	    case 0:
+		break;
+	    case EPERM:
+		throw exception_system("Not allowed to set the requested thread scheduling policy and priority: ", ret);
+	    case EINVAL:
+		if(! affinity.empty())
+		    throw exception_range("CPU affinity set contains no CPU available on this system");
+		throw exception_system("Failed creating a new thread: ", ret);
+	    default:
+		throw exception_system("Failed creating a new thread: ", ret);
+	    }
 	    running = true;
 	    joignable = true;
 	}
@@ -284,10 +508,21 @@ namespace libthreadar
 
     void thread::cancel()
     {
+	cancellation_token tok = get_cancellation_token();
+
+	    // wakes the thread if suspended on a condition
+	tok.cancel();
+	inherited_cancel();
+    }
+
+    cancellation_token thread::get_cancellation_token() const
+    {
+	cancellation_token ret(nullptr);
+
 	field_control.lock();
 	try
 	{
-	    do_cancel = true;
+	    ret = cancel_token;
 	}
 	catch(...)
 	{
@@ -296,30 +531,287 @@ namespace libthreadar
 	}
 	field_control.unlock();
 
-	inherited_cancel();
+	return ret;
+    }
+
+    thread::cpu_usage thread::get_cpu_usage() const
+    {
+	cpu_usage ret;
+
+	field_control.lock();
+	try
+	{
+	    if(running)
+		other_cpu_usage(tid, kernel_tid, ret);
+	    else
+		ret = final_usage;
+	}
+	catch(...)
+	{
+	    field_control.unlock();
+	    throw;
+	}
+	field_control.unlock();
+
+	return ret;
     }
 
     void thread::cancellation_checkpoint() const
     {
-	    // we run without lock the field_control mutex
-	    // for efficiency
-	    // either do_cancel value is still true
-	    // either is not but it cannot have other
-	    // values so locking is not necessary to read
-	    // this value
-	if(do_cancel)
-	    throw cancel_except();
+	    // lock-free, the token is only replaced
+	    // by run() when no thread is running
+	cancel_token.checkpoint();
+    }
+
+    void thread::set_name(const string & val)
+    {
+	field_control.lock();
+	try
+	{
+	    name = val;
+	    if(running)
+		apply_name();
+	}
+	catch(...)
+	{
+	    field_control.unlock();
+	    throw;
+	}
+	field_control.unlock();
+    }
+
+    string thread::get_name() const
+    {
+	string ret;
+
+	field_control.lock();
+	try
+	{
+	    ret = name;
+	}
+	catch(...)
+	{
+	    field_control.unlock();
+	    throw;
+	}
+	field_control.unlock();
+
+	return ret;
+    }
+
+    vector<thread::thread_info> thread::get_live_threads()
+    {
+	registry & reg = live_registry();
+	vector<thread_info> ret;
+
+	reg.control.lock();
+	try
+	{
+	    for(set<thread *>::iterator it = reg.live.begin(); it != reg.live.end(); ++it)
+	    {
+		thread_info info;
+		cancellation_token tok(nullptr);
+
+		if(*it == nullptr)
+		    throw THREADAR_BUG;
+
+		(*it)->field_control.lock();
+		try
+		{
+		    info.name = (*it)->name;
+		    info.tid = (*it)->tid;
+		    info.kernel_tid = (*it)->kernel_tid;
+		    tok = (*it)->cancel_token;
+		}
+		catch(...)
+		{
+		    (*it)->field_control.unlock();
+		    throw;
+		}
+		(*it)->field_control.unlock();
+
+		if(tok.is_cancelled())
+		    info.state = run_state::cancelling;
+		else if(tok.has_registered_waits())
+		    info.state = run_state::waiting;
+		else
+		    info.state = run_state::running;
+
+		ret.push_back(info);
+	    }
+	}
+	catch(...)
+	{
+	    reg.control.unlock();
+	    throw;
+	}
+	reg.control.unlock();
+
+	return ret;
+    }
+
+    bool thread::is_waiting_on_condition() const
+    {
+	cancellation_token tok = get_cancellation_token();
+
+	return tok.has_registered_waits();
     }
 
     void thread::clear_stack()
     {
 	if(stack != nullptr)
 	{
-	    delete [] stack;
+	    stack_pool::release(stack, stack_size);
 	    stack = nullptr;
 	}
     }
 
+    void thread::ended()
+    {
+	cpu_usage usage;
+
+	self_cpu_usage(usage);
+	unregister_thread(this);
+
+	field_control.lock();
+	final_usage = usage;
+	running = false;
+	field_control.unlock();
+    }
+
+    void thread::apply_name() const
+    {
+	    // must be called with field_control acquired
+	    // and the thread running
+
+#if HAVE_PTHREAD_SETNAME_NP
+	    // the system limits the name to 16 bytes including the terminal zero
+	string sysname = name.substr(0, 15);
+	int err = pthread_setname_np(tid, sysname.c_str());
+
+	if(err != 0)
+	    throw exception_system("Failed setting thread name: ", err);
+#endif
+    }
+
+    void thread::register_thread(thread *obj)
+    {
+	registry & reg = live_registry();
+
+	reg.control.lock();
+	try
+	{
+	    reg.live.insert(obj);
+	}
+	catch(...)
+	{
+	    reg.control.unlock();
+	    throw;
+	}
+	reg.control.unlock();
+    }
+
+    void thread::unregister_thread(thread *obj)
+    {
+	registry & reg = live_registry();
+
+	reg.control.lock();
+	reg.live.erase(obj);
+	reg.control.unlock();
+    }
+
+    void thread::self_cpu_usage(cpu_usage & usage)
+    {
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_THREAD_CPUTIME_ID)
+	struct timespec ts;
+
+	if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+	    usage.cpu_time = chrono::seconds(ts.tv_sec) + chrono::nanoseconds(ts.tv_nsec);
+#endif
+
+#if HAVE_GETRUSAGE && defined(RUSAGE_THREAD)
+	struct rusage ru;
+
+	if(getrusage(RUSAGE_THREAD, &ru) == 0)
+	{
+	    usage.user_time = chrono::seconds(ru.ru_utime.tv_sec) + chrono::microseconds(ru.ru_utime.tv_usec);
+	    usage.system_time = chrono::seconds(ru.ru_stime.tv_sec) + chrono::microseconds(ru.ru_stime.tv_usec);
+	    usage.voluntary_switches = ru.ru_nvcsw;
+	    usage.involuntary_switches = ru.ru_nivcsw;
+	}
+#endif
+    }
+
+    void thread::other_cpu_usage(pthread_t tid, int ktid, cpu_usage & usage)
+    {
+	if(pthread_equal(tid, pthread_self()))
+	{
+	    self_cpu_usage(usage);
+	    return;
+	}
+
+#if HAVE_PTHREAD_GETCPUCLOCKID && HAVE_CLOCK_GETTIME
+	clockid_t cid;
+	struct timespec ts;
+
+	if(pthread_getcpuclockid(tid, &cid) == 0 && clock_gettime(cid, &ts) == 0)
+	    usage.cpu_time = chrono::seconds(ts.tv_sec) + chrono::nanoseconds(ts.tv_nsec);
+#endif
+
+	if(ktid != 0)
+	{
+	    string dir = string("/proc/self/task/") + tools_convert_to_string(ktid) + "/";
+	    ifstream stat((dir + "stat").c_str());
+	    ifstream status((dir + "status").c_str());
+	    string line;
+
+	    if(stat && getline(stat, line))
+	    {
+		    // the second field (command name) may contain spaces
+		    // but is enclosed in parenthesis
+		string::size_type pos = line.rfind(')');
+
+		if(pos != string::npos)
+		{
+		    istringstream fields(line.substr(pos + 1));
+		    string field;
+		    unsigned long long utime = 0, stime = 0;
+		    long ticks = 100;
+
+#if HAVE_UNISTD_H
+		    ticks = sysconf(_SC_CLK_TCK);
+		    if(ticks <= 0)
+			ticks = 100;
+#endif
+			// utime and stime are the 14th and 15th fields,
+			// the 12th and 13th after the command name
+		    for(unsigned int i = 3; i < 14 && (fields >> field); ++i)
+			;
+		    if(fields >> utime >> stime)
+		    {
+			usage.user_time = chrono::nanoseconds(utime * 1000000000ULL / ticks);
+			usage.system_time = chrono::nanoseconds(stime * 1000000000ULL / ticks);
+		    }
+		}
+	    }
+
+	    while(status && getline(status, line))
+	    {
+		istringstream fields(line);
+		string key;
+		unsigned long val;
+
+		if(fields >> key >> val)
+		{
+		    if(key == "voluntary_ctxt_switches:")
+			usage.voluntary_switches = val;
+		    else if(key == "nonvoluntary_ctxt_switches:")
+			usage.involuntary_switches = val;
+		}
+	    }
+	}
+    }
+
     void *thread::run_obj(void *obj)
     {
 	exception_ptr *ret = nullptr;
@@ -333,12 +825,56 @@ namespace libthreadar
 		// locking and unlocking object's mutex is a simple form of barrier
 		// this way we start working only when the caller has exited run()
 	    tobj->field_control.lock();
+#if defined(SYS_gettid)
+	    tobj->kernel_tid = syscall(SYS_gettid);
+#endif
+	    try
+	    {
+		if(! tobj->name.empty())
+		    tobj->apply_name();
+	    }
+	    catch(...)
+	    {
+		tobj->field_control.unlock();
+		tobj->ended();
+		throw;
+	    }
 	    tobj->field_control.unlock();
+	    register_thread(tobj);
 	    if(pthread_sigmask(SIG_SETMASK , &(tobj->sigmask), NULL) != 0)
+	    {
+		tobj->ended();
 		throw exception_system("Failing setting signal mask for thread", errno);
+	    }
 
 	    try
 	    {
+		if(tobj->sched == sched_policy::batch || tobj->sched == sched_policy::idle)
+		{
+		    struct sched_param param;
+		    int err;
+
+		    param.sched_priority = 0;
+		    err = pthread_setschedparam(pthread_self(), native_policy(tobj->sched), &param);
+		    if(err != 0)
+			throw exception_system("Failed setting thread scheduling policy: ", err);
+		}
+
+		if(nice_applies(tobj->sched))
+		{
+#if HAVE_SETPRIORITY && defined(SYS_gettid)
+			// under Linux the nice value is a per thread attribute
+			// and is not part of the pthread scheduling parameters
+		    if(setpriority(PRIO_PROCESS, syscall(SYS_gettid), tobj->sched_prio) != 0)
+			throw exception_system("Failed setting thread nice value: ", errno);
+#else
+		    if(tobj->sched_prio != 0)
+			throw exception_feature("per thread nice value");
+#endif
+		}
+
+		cancellation_token::scope current(tobj->cancel_token);
+
 		tobj->inherited_run();
 	    }
 	    catch(cancel_except &)
@@ -351,12 +887,10 @@ namespace libthreadar
 	    }
 	    catch(...)
 	    {
-		    // no need to use the mutex here as only this thread has to set
-		    // back running to false
-		tobj->running = false;
+		tobj->ended();
 		throw;
 	    }
-	    tobj->running = false;
+	    tobj->ended();
 	}
 	catch(...)
 	{
@@ -366,4 +900,38 @@ namespace libthreadar
 	return ret;
     }
 
+    static int native_policy(thread::sched_policy policy)
+    {
+	switch(policy)
+	{
+	case thread::sched_policy::inherit:
+	case thread::sched_policy::other:
+	    return SCHED_OTHER;
+	case thread::sched_policy::batch:
+#ifdef SCHED_BATCH
+	    return SCHED_BATCH;
+#else
+	    throw exception_feature("SCHED_BATCH scheduling policy");
+#endif
+	case thread::sched_policy::idle:
+#ifdef SCHED_IDLE
+	    return SCHED_IDLE;
+#else
+	    throw exception_feature("SCHED_IDLE scheduling policy");
+#endif
+	case thread::sched_policy::fifo:
+	    return SCHED_FIFO;
+	case thread::sched_policy::rr:
+	    return SCHED_RR;
+	default:
+	    throw THREADAR_BUG;
+	}
+    }
+
+    static bool nice_applies(thread::sched_policy policy)
+    {
+	return policy == thread::sched_policy::other
+	    || policy == thread::sched_policy::batch;
+    }
+
 } // end of namespace
@@ -45,10 +45,14 @@ extern "C"
 #endif
 }
     // C++ standard headers
-
+#include <set>
+#include <string>
+#include <vector>
+#include <chrono>
 
     // libthreadar headers
 #include "mutex.hpp"
+#include "cancellation_token.hpp"
 
 namespace libthreadar
 {
@@ -116,15 +120,18 @@ namespace libthreadar
 	    /// reset the stack size to the system default value
 
 	    /// this method must not be called when the current object has its
-	    /// thread running.
+	    /// thread running or not yet joined.
 	    /// \note this sets back the stack to the system default
 	void reset_stack_size();
 
 	    /// set the stack size to non default value
 
 	    /// this method must not be called when the current object has its
-	    /// thread running.
+	    /// thread running or not yet joined.
 	    /// \param[in] val size in bytes of the stack to allocate and use.
+	    /// \note the stack is obtained from the stack_pool class, it is page aligned, its size is
+	    /// rounded up to a multiple of the page size and it is protected by a guard page. It is given
+	    /// back to the pool when the stack size is changed or the object is destroyed.
 	void set_stack_size(unsigned int val);
 
 	    /// get the current stack size value
@@ -139,6 +146,65 @@ namespace libthreadar
 	    /// \note see sigsetops(3) for details on manipulating signal sets
 	virtual void set_signal_mask(const sigset_t & mask) { sigmask = mask; };
 
+	    /// restrict the CPUs the thread spawn by run() is allowed to run on
+
+	    /// this method must not be called when the current object has its
+	    /// thread running. The CPU set is applied at thread creation time
+	    /// and persists accross several run()/join() executions.
+	    /// \param[in] cpus set of CPU numbers, an empty set means no restriction
+	    /// \note see class cpu_topology to obtain the CPUs of a NUMA node or sharing a cache
+	    /// \note on systems lacking pthread_attr_setaffinity_np() a non empty set leads
+	    /// run() to throw an exception_feature
+	void set_cpu_affinity(const std::set<unsigned int> & cpus);
+
+	    /// restrict the thread spawn by run() to the CPUs of the given NUMA node
+
+	    /// this is a shortcut for set_cpu_affinity(cpu_topology::node_cpus(node)).
+	    /// As memory is allocated by default on the node of the CPU that first uses it,
+	    /// data allocated by the thread is also likely to be local to this NUMA node.
+	void set_numa_node(unsigned int node);
+
+	    /// let the thread spawn by run() run on any CPU (this is the default)
+	void reset_cpu_affinity();
+
+	    /// get the CPU set the thread is restricted to (empty set for no restriction)
+	std::set<unsigned int> get_cpu_affinity() const;
+
+	    /// scheduling policies available for set_scheduling()
+	enum class sched_policy
+	{
+	    inherit, ///< the thread inherits the scheduling of the thread calling run() (default)
+	    other,   ///< SCHED_OTHER default time-sharing policy, the priority is a nice value
+	    batch,   ///< SCHED_BATCH for CPU-bound non-interactive threads, the priority is a nice value
+	    idle,    ///< SCHED_IDLE the thread only runs when the CPU has nothing else to do, priority is ignored
+	    fifo,    ///< SCHED_FIFO real-time policy, the priority is a real-time priority
+	    rr       ///< SCHED_RR real-time round-robin policy, the priority is a real-time priority
+	};
+
+	    /// set the scheduling policy and priority of the thread spawn by run()
+
+	    /// this method must not be called when the current object has its
+	    /// thread running. The setting persists accross several run()/join() executions.
+	    /// \param[in] policy the scheduling policy to use
+	    /// \param[in] priority for fifo and rr this is a real-time priority in the range given by
+	    /// sched_get_priority_min() and sched_get_priority_max() (1 to 99 under Linux), for other and batch
+	    /// this is a nice value from -20 (most favorable) to 19 (least favorable), it is ignored for idle
+	    /// and inherit.
+	    /// \note real-time policies and negative nice values usually require privileges (CAP_SYS_NICE or
+	    /// RLIMIT_RTPRIO/RLIMIT_NICE resource limits). Lacking them, run() throws an exception_system for
+	    /// real-time policies, while for nice values the thread fails before calling inherited_run() and
+	    /// the exception_system is rethrown by join().
+	void set_scheduling(sched_policy policy, int priority = 0);
+
+	    /// let the thread spawn by run() inherit the scheduling of the caller of run() (this is the default)
+	void reset_scheduling() { set_scheduling(sched_policy::inherit); };
+
+	    /// get the scheduling policy set by set_scheduling()
+	sched_policy get_scheduling_policy() const { return sched; };
+
+	    /// get the scheduling priority or nice value set by set_scheduling()
+	int get_scheduling_priority() const { return sched_prio; };
+
 	    /// launch the current object routing in a separated thread
 	void run();
 
@@ -169,11 +235,75 @@ namespace libthreadar
 	    /// regularly in its loop(s), see below. As an alternative, the inherited class can
 	    /// rely in the protected method inherited_cancel() to implement a mechanism to stop
 	    /// the possibly running thread.
+	    /// \note if the thread is suspended on a libthreadar::condition (and thus on any
+	    /// libthreadar object relying on it, like fast_tampon, freezer, semaphore, ratelier_scatter,
+	    /// ratelier_gather or thread_pool), it is awaken and condition::wait() throws
+	    /// the cancel_except exception as cancellation_checkpoint() does. Only this condition
+	    /// instance is awaken, no signal is involved.
+	    /// \note cancel() does not block: if the lock of the condition is held, for example by
+	    /// the caller, the thread holding it awakes the waiting thread when releasing the lock.
+	    /// \note this cancels the token returned by get_cancellation_token()
 	void cancel();
 
+	    /// the cancellation token of the thread
 
+	    /// this token is cancelled by cancel() and is the current token (see cancellation_token::current())
+	    /// of the thread running inherited_run(). A new token is created each time run() is called.
+	cancellation_token get_cancellation_token() const;
 
-    protected:
+	    /// CPU resources used by a thread
+	struct cpu_usage
+	{
+	    std::chrono::nanoseconds cpu_time;     ///< total CPU time (user and system)
+	    std::chrono::nanoseconds user_time;    ///< CPU time spent in user mode
+	    std::chrono::nanoseconds system_time;  ///< CPU time spent in the kernel on behalf of the thread
+	    unsigned long voluntary_switches;      ///< context switches due to the thread waiting (lock, I/O...)
+	    unsigned long involuntary_switches;    ///< context switches due to preemption by the scheduler
+
+	    cpu_usage(): cpu_time(0), user_time(0), system_time(0) { voluntary_switches = 0; involuntary_switches = 0; };
+	};
+
+	    /// CPU resources used by the thread so far
+
+	    /// while the thread is running the values are read from the system (pthread_getcpuclockid()
+	    /// for cpu_time, /proc/self/task for the other fields under Linux), once the thread has ended
+	    /// the values recorded by the thread at its end are returned, and they stay available after
+	    /// join() up to the next call to run().
+	    /// \note fields the system cannot provide are left to zero
+	cpu_usage get_cpu_usage() const;
+
+	    /// give a name to the thread
+
+	    /// the name is applied by pthread_setname_np() at the start of the thread, so it shows up
+	    /// in top -H, ps -L, gdb, perf... If the thread is already running the name is applied at once.
+	    /// \note the system limits the name to 15 characters, longer names are truncated for the system
+	    /// but are reported whole by get_name() and get_live_threads()
+	void set_name(const std::string & val);
+
+	    /// the name given to the thread by set_name(), empty string by default
+	std::string get_name() const;
+
+	    /// state of a running thread as reported by get_live_threads()
+	enum class run_state
+	{
+	    running,     ///< running inherited_run()
+	    waiting,     ///< suspended on a libthreadar::condition (thus also tampon, rateliers, thread_pool...)
+	    cancelling   ///< cancel() has been called but the thread has not yet ended
+	};
+
+	    /// description of a running thread as reported by get_live_threads()
+	struct thread_info
+	{
+	    std::string name;         ///< name given by set_name()
+	    pthread_t tid;            ///< pthread ID of the thread
+	    int kernel_tid;           ///< kernel thread ID (as shown by top -H), 0 if unknown
+	    run_state state;          ///< state of the thread
+	};
+
+	    /// list the libthreadar threads currently running
+
+	    /// a thread is listed from the start of the thread up to the return of inherited_run()
+	static std::vector<thread_info> get_live_threads();
 
 	    /// exception used to trigger thread cancellation
 
@@ -182,13 +312,17 @@ namespace libthreadar
 	{
 	public:
 	    cancel_except() {};
-	    cancel_except(cancel_except &) = default;
+	    cancel_except(const cancel_except &) = default;
 	    cancel_except(cancel_except &&) noexcept = default;
-	    cancel_except & operator = (cancel_except &) = default;
+	    cancel_except & operator = (const cancel_except &) = default;
 	    cancel_except & operator = (cancel_except &&) noexcept = default;
 	    ~cancel_except() = default;
 	};
 
+
+
+    protected:
+
 	    /// action to be performed in the separated thread (implementation is expected in inherited classes)
 
 	    /// \note There is no argument to provide, because this is the responsibility of the inherited class
@@ -250,18 +384,35 @@ namespace libthreadar
 	    /// calling cancel().
 	virtual void inherited_cancel() {};
 
+	    /// whether the thread is currently suspended on a libthreadar::condition
+	bool is_waiting_on_condition() const;
+
     private:
 	mutable mutex field_control;   ///< mutex protecting access to object's data
 	bool running;                  ///< whether a thread is running
 	pthread_t tid;                 ///< the thread ID of the running thread if any
 	bool joignable;                ///< whether exist status of thread has to be retrieved
-	mutable bool do_cancel;        ///< whether thread should cancel/stop
+	cancellation_token cancel_token; ///< whether thread should cancel/stop
 	sigset_t sigmask;              ///< signal mask to use for the thread
 	unsigned int stack_size;       ///< stack size when non-default stack is used, 0 if system default stack is used
-	char* stack;                   ///< allocated stack when non-default size is requested
+	char* stack;                   ///< stack obtained from stack_pool when non-default size is requested
+	std::set<unsigned int> affinity; ///< CPUs the thread is restricted to, empty for no restriction
+	sched_policy sched;            ///< scheduling policy of the thread
+	int sched_prio;                ///< real-time priority or nice value depending on sched
+	int kernel_tid;                ///< kernel thread ID of the running thread, 0 if unknown
+	cpu_usage final_usage;         ///< CPU usage recorded by the thread at its end
+	std::string name;              ///< name of the thread, empty for none
 
 
 	void clear_stack();
+	void ended();
+	void apply_name() const;
+
+	static void register_thread(thread *obj);
+	static void unregister_thread(thread *obj);
+
+	static void self_cpu_usage(cpu_usage & usage);
+	static void other_cpu_usage(pthread_t tid, int ktid, cpu_usage & usage);
 
 	    // static members
 
@@ -0,0 +1,341 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <new>
+
+    // libthreadar headers
+
+    // this module's header
+#include "thread_pool.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+    bool thread_pool::handle::is_done() const
+    {
+	bool ret;
+
+	if(! st)
+	    throw exception_range("thread_pool::handle not associated to any task");
+
+	st->verrou.lock();
+	ret = st->done;
+	st->verrou.unlock();
+
+	return ret;
+    }
+
+    void thread_pool::handle::wait() const
+    {
+	exception_ptr except;
+
+	if(! st)
+	    throw exception_range("thread_pool::handle not associated to any task");
+
+	st->verrou.lock();
+	try
+	{
+	    while(! st->done)
+		st->verrou.wait();
+	    except = st->except;
+	}
+	catch(...)
+	{
+	    st->verrou.unlock();
+	    throw;
+	}
+	st->verrou.unlock();
+
+	if(except)
+	    rethrow_exception(except);
+    }
+
+    thread_pool::thread_pool(unsigned int num, unsigned int max_num): verrou(2)
+    {
+	if(num < 1)
+	    throw exception_range("a thread_pool needs at least one worker");
+
+	min_workers = num;
+	max_workers = max_num == 0 ? num : max_num;
+	if(max_workers < min_workers)
+	    throw exception_range("maximum number of workers of thread_pool lower than its minimum");
+	live = 0;
+	busy = 0;
+	stopping = false;
+
+	verrou.lock();
+	try
+	{
+	    for(unsigned int i = 0; i < min_workers; ++i)
+		spawn();
+	}
+	catch(...)
+	{
+	    stopping = true;
+	    verrou.broadcast(cond_task);
+	    verrou.unlock();
+	    workers.clear(); // worker destructor joins the thread
+	    throw;
+	}
+	verrou.unlock();
+    }
+
+    thread_pool::~thread_pool()
+    {
+	try
+	{
+	    verrou.lock();
+	    stopping = true;
+	    verrou.broadcast(cond_task);
+	    verrou.unlock();
+
+		// no more worker can be created now
+		// workers end once the queue is empty
+	    for(list<unique_ptr<worker> >::iterator it = workers.begin(); it != workers.end(); ++it)
+		if(*it)
+		    (*it)->join();
+	}
+	catch(...)
+	{
+		// a destructor should not generate exceptions
+	}
+	workers.clear();
+    }
+
+    thread_pool::handle thread_pool::submit(const function<void()> & task)
+    {
+	handle ret;
+	job j;
+
+	if(! task)
+	    throw exception_range("cannot submit an empty task to a thread_pool");
+
+	j.task = task;
+	push_job(j);
+	ret.st = j.st;
+
+	return ret;
+    }
+
+    void thread_pool::wait_all()
+    {
+	verrou.lock();
+	try
+	{
+	    while(! queue.empty() || busy > 0)
+		verrou.wait(cond_idle);
+	}
+	catch(...)
+	{
+	    verrou.unlock();
+	    throw;
+	}
+	verrou.unlock();
+    }
+
+    unsigned int thread_pool::get_num_workers() const
+    {
+	unsigned int ret;
+
+	verrou.lock();
+	ret = live;
+	verrou.unlock();
+
+	return ret;
+    }
+
+    unsigned int thread_pool::get_pending() const
+    {
+	unsigned int ret;
+
+	verrou.lock();
+	ret = queue.size();
+	verrou.unlock();
+
+	return ret;
+    }
+
+    void thread_pool::push_job(job & j)
+    {
+	j.st.reset(new (nothrow) state());
+	if(! j.st)
+	    throw exception_memory();
+	if(cancellation_token::has_current())
+	    j.token = cancellation_token::current();
+
+	verrou.lock();
+	try
+	{
+	    unsigned int idle = verrou.get_waiting_thread_count(cond_task);
+
+	    if(stopping)
+		throw exception_thread("cannot submit a task to a thread_pool being destroyed");
+
+	    queue.push_back(j);
+
+	    if(idle > 0)
+		verrou.signal(cond_task);
+
+	    if(queue.size() > idle && live < max_workers)
+		spawn(); // all workers are busy, growing the pool
+	}
+	catch(...)
+	{
+	    verrou.unlock();
+	    throw;
+	}
+	verrou.unlock();
+    }
+
+    void thread_pool::work(worker *me)
+    {
+	job j;
+	bool leave = false;
+
+	if(me == nullptr)
+	    throw THREADAR_BUG;
+
+	verrou.lock();
+	try
+	{
+	    while(! leave)
+	    {
+		if(queue.empty())
+		{
+		    if(stopping || live > min_workers)
+			leave = true;
+		    else
+			verrou.wait(cond_task);
+		}
+		else
+		{
+		    j = std::move(queue.front());
+		    queue.pop_front();
+		    ++busy;
+		    verrou.unlock();
+
+		    run_job(j);
+		    j.task = nullptr;
+		    j.st.reset();
+		    j.token = cancellation_token(nullptr);
+
+		    verrou.lock();
+		    --busy;
+		    if(busy == 0 && queue.empty() && verrou.get_waiting_thread_count(cond_idle) > 0)
+			verrou.broadcast(cond_idle);
+		}
+	    }
+
+	    --live;
+	    me->ended = true;
+	}
+	catch(...)
+	{
+	    verrou.unlock();
+	    throw;
+	}
+	verrou.unlock();
+    }
+
+    void thread_pool::spawn()
+    {
+	    // must be called with verrou acquired
+
+	reap();
+
+	workers.push_back(unique_ptr<worker>(new (nothrow) worker(*this)));
+	if(! workers.back())
+	{
+	    workers.pop_back();
+	    throw exception_memory();
+	}
+
+	try
+	{
+	    workers.back()->run();
+	}
+	catch(...)
+	{
+	    workers.pop_back();
+	    throw;
+	}
+	++live;
+    }
+
+    void thread_pool::reap()
+    {
+	    // must be called with verrou acquired
+
+	list<unique_ptr<worker> >::iterator it = workers.begin();
+
+	while(it != workers.end())
+	{
+	    if(*it && (*it)->ended)
+	    {
+		    // the worker has left its loop and does
+		    // not need the lock to end
+		(*it)->join();
+		it = workers.erase(it);
+	    }
+	    else
+		++it;
+	}
+    }
+
+    void thread_pool::run_job(job & j)
+    {
+	exception_ptr except;
+
+	if(! j.st)
+	    throw THREADAR_BUG;
+
+	try
+	{
+	    cancellation_token::scope current(j.token);
+
+	    if(j.token.st)
+		j.token.checkpoint(); // not starting an already cancelled task
+	    j.task();
+	}
+	catch(...)
+	{
+	    except = current_exception();
+	}
+
+	j.st->verrou.lock();
+	j.st->done = true;
+	j.st->except = except;
+	j.st->verrou.broadcast();
+	j.st->verrou.unlock();
+    }
+
+} // end of namespace
@@ -0,0 +1,254 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+#ifndef LIBTHREADAR_THREAD_POOL_HPP
+#define LIBTHREADAR_THREAD_POOL_HPP
+
+    /// \file thread_pool.hpp
+    /// \brief defines the thread_pool class that runs tasks over a set of persistent threads
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <deque>
+#include <list>
+#include <memory>
+#include <functional>
+#include <exception>
+
+    // libthreadar headers
+#include "exceptions.hpp"
+#include "condition.hpp"
+#include "thread.hpp"
+
+namespace libthreadar
+{
+
+	/// Class thread_pool runs tasks on a set of persistent worker threads
+
+	/// Running a short task in its own libthreadar::thread costs the creation of a new
+	/// thread each time. A thread_pool keeps its worker threads alive between tasks: submit()
+	/// queues a task (any callable object with no argument) and returns a handle that can be used to
+	/// wait for its completion. If the task throws an exception, it is transmitted to the thread
+	/// calling handle::wait() the same way thread::join() does for a thread.
+	///
+	/// The pool can be of fixed size, or elastic: in that later case, it starts with a minimum number
+	/// of workers, creates new ones up to a maximum number when a task is submitted while all
+	/// workers are busy, and the workers above the minimum number end once they find no more task to run.
+	///
+	/// \note a task should not wait for the completion of another task of the same pool
+	/// unless the pool can grow enough, else all workers could end waiting for tasks no worker would run.
+	/// \note the destructor lets the workers complete all the queued tasks before returning
+	/// \note a task runs with the current cancellation token of the thread that submitted it
+	/// (see cancellation_token::current()), a task which token is cancelled before it starts is
+	/// not run and its handle reports thread::cancel_except.
+
+    class thread_pool
+    {
+    private:
+	struct state;
+
+    public:
+
+	    /// handle on a submitted task
+
+	    /// handles can be copied, all copies refer to the same task
+	class handle
+	{
+	public:
+		/// an empty handle, not associated to any task
+	    handle() {};
+	    handle(const handle & ref) = default;
+	    handle(handle && ref) noexcept = default;
+	    handle & operator = (const handle & ref) = default;
+	    handle & operator = (handle && ref) noexcept = default;
+	    virtual ~handle() = default;
+
+		/// whether the handle is associated to a task
+	    bool valid() const { return bool(st); };
+
+		/// whether the task has completed (either normally or by mean of an exception)
+	    bool is_done() const;
+
+		/// suspend the caller up to the completion of the task
+
+		/// \note if the task ended by throwing an exception, this exception is rethrown here,
+		/// and for each subsequent call to wait().
+	    void wait() const;
+
+	protected:
+	    std::shared_ptr<state> st;
+
+	    friend class thread_pool;
+	};
+
+	    /// handle on a submitted task that returns a value
+	template <class R> class result : public handle
+	{
+	public:
+	    result() {};
+
+		/// wait for the task completion and return the value the task returned
+
+		/// \note if the task ended by throwing an exception, this exception is rethrown here
+	    R & get() const { wait(); if(!value || !(*value)) throw THREADAR_BUG; return **value; };
+
+	private:
+	    std::shared_ptr<std::unique_ptr<R> > value;
+
+	    friend class thread_pool;
+	};
+
+	    /// constructor
+
+	    /// \param[in] num number of workers to start with, must be at least one
+	    /// \param[in] max_num maximum number of workers, zero (or num) for a fixed size pool
+	thread_pool(unsigned int num, unsigned int max_num = 0);
+
+	    /// no copy constructor
+	thread_pool(const thread_pool & ref) = delete;
+
+	    /// no move constructor (workers refer to the object)
+	thread_pool(thread_pool && ref) = delete;
+
+	    /// no assignment operator
+	thread_pool & operator = (const thread_pool & ref) = delete;
+
+	    /// no move operator
+	thread_pool & operator = (thread_pool && ref) = delete;
+
+	    /// destructor, waits for all queued tasks to complete
+	~thread_pool();
+
+	    /// queue a task to be run by a worker
+
+	    /// \param[in] task the task to run
+	    /// \return a handle to wait for the task completion
+	handle submit(const std::function<void()> & task);
+
+	    /// queue a task returning a value
+
+	    /// \param[in] task the task to run
+	    /// \return a handle to wait for the task completion and obtain the returned value
+	template <class R> result<R> submit_result(const std::function<R()> & task);
+
+	    /// suspend the caller until no task is queued or running
+	void wait_all();
+
+	    /// current number of worker threads
+	unsigned int get_num_workers() const;
+
+	    /// number of tasks queued and not yet run by a worker
+	unsigned int get_pending() const;
+
+	    /// minimum number of workers
+	unsigned int get_min_workers() const { return min_workers; };
+
+	    /// maximum number of workers
+	unsigned int get_max_workers() const { return max_workers; };
+
+    private:
+	static const unsigned int cond_task = 0;  ///< workers waiting for a task
+	static const unsigned int cond_idle = 1;  ///< threads waiting for the pool to become idle
+
+	struct state
+	{
+	    condition verrou;             ///< protects the fields and lets wait() suspend
+	    bool done;                    ///< whether the task has completed
+	    std::exception_ptr except;    ///< exception thrown by the task if any
+
+	    state(): verrou(1) { done = false; };
+	};
+
+	struct job
+	{
+	    std::function<void()> task;
+	    std::shared_ptr<state> st;
+	    cancellation_token token;   ///< current token of the submitter, without state if it had none
+
+	    job(): token(nullptr) {};
+	};
+
+	class worker : public thread
+	{
+	public:
+	    worker(thread_pool & owner): pool(owner) { ended = false; };
+	    worker(const worker & ref) = delete;
+	    worker & operator = (const worker & ref) = delete;
+	    ~worker() { try { cancel(); join(); } catch(...) {} };
+
+	    bool ended;  ///< set under the pool lock when the worker leaves its loop
+
+	protected:
+	    virtual void inherited_run() override { pool.work(this); };
+
+	private:
+	    thread_pool & pool;
+	};
+
+	unsigned int min_workers;       ///< number of workers the pool does not shrink under
+	unsigned int max_workers;       ///< number of workers the pool does not grow above
+	unsigned int live;              ///< number of workers running their loop
+	unsigned int busy;              ///< number of workers running a task
+	bool stopping;                  ///< whether the destructor has been called
+	std::deque<job> queue;          ///< submitted tasks not yet run
+	std::list<std::unique_ptr<worker> > workers; ///< worker threads
+	mutable condition verrou;       ///< protects the fields above
+
+	void push_job(job & j);
+	void work(worker *me);
+	void spawn();
+	void reap();
+
+	static void run_job(job & j);
+    };
+
+    template <class R> thread_pool::result<R> thread_pool::submit_result(const std::function<R()> & task)
+    {
+	result<R> ret;
+	job j;
+
+	if(! task)
+	    throw exception_range("cannot submit an empty task to a thread_pool");
+
+	ret.value.reset(new (std::nothrow) std::unique_ptr<R>());
+	if(! ret.value)
+	    throw exception_memory();
+
+	std::shared_ptr<std::unique_ptr<R> > value = ret.value;
+	std::function<R()> fn = task;
+	j.task = [value, fn]() { value->reset(new R(fn())); };
+
+	push_job(j);
+	ret.st = j.st;
+
+	return ret;
+    }
+
+} // end of namespace
+
+#endif
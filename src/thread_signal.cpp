@@ -109,8 +109,10 @@ namespace libthreadar
     {
 	pthread_t tid;
 
-	    // awaking the thread if it was pending on a system call
-	if(is_running(tid))
+	    // awaking the thread if it was pending on a system call,
+	    // a thread suspended on a libthreadar condition has already
+	    // been awaken by thread::cancel()
+	if(is_running(tid) && ! is_waiting_on_condition())
 	{
 	    if(pthread_kill(tid, awaking_signal) != 0)
 		throw exception_system("Error calling pthread_kill(): ", errno);
@@ -56,6 +56,9 @@ namespace libthreadar
 	/// continue to run normally, except for the point when the thread was pending on a system call
 	/// which will in that case return EINTR.
 	/// \note the signal used for this class can be set using the static method change_default_signal()
+	/// \note a thread suspended on a libthreadar::condition (or any class relying on it) is awaken
+	/// by thread::cancel() without signal, the signal is only sent to threads that are not suspended
+	/// on such a libthreadar object.
 
     class thread_signal: public thread
     {
@@ -0,0 +1,111 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_TICKET_MUTEX_HPP
+#define LIBTHREADAR_TICKET_MUTEX_HPP
+
+    /// \file ticket_mutex.hpp
+    /// \brief defines the ticket_mutex class, a fair busy waiting lock
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+
+    // libthreadar headers
+
+namespace libthreadar
+{
+
+	/// Class ticket_mutex is a fair spin lock granting the lock in FIFO order
+
+	/// It has the same lock(), unlock() and try_lock() methods as libthreadar::mutex.
+	/// Each thread calling lock() takes a ticket and busy waits until the ticket being
+	/// served is its own, unlock() serves the next ticket. Threads thus acquire the mutex
+	/// in the order they called lock(), which avoids starvation of a thread under
+	/// contention, at the cost of all waiting threads polling the same cache line.
+	/// For many concurrent waiters, see mcs_mutex.
+	///
+	/// \note there is no error checking: unlocking a ticket_mutex not locked or locking it twice
+	/// from the same thread is undefined behavior
+	/// \note as the lock is granted in order, a thread preempted while waiting delays all threads
+	/// waiting behind it, ticket_mutex should thus not be used with more threads than CPUs
+    class ticket_mutex
+    {
+    public:
+	    /// constructor
+	ticket_mutex(): next(0), serving(0) {};
+
+	    /// no copy constructor
+	ticket_mutex(const ticket_mutex & ref) = delete;
+
+	    /// no move constructor
+	ticket_mutex(ticket_mutex && ref) = delete;
+
+	    /// no assignment operator
+	ticket_mutex & operator = (const ticket_mutex & ref) = delete;
+
+	    /// no move operator
+	ticket_mutex & operator = (ticket_mutex && ref) = delete;
+
+	    /// destructor
+	~ticket_mutex() = default;
+
+	    /// lock the mutex, busy waiting for the threads that called lock() before
+	void lock()
+	{
+	    unsigned int ticket = next.fetch_add(1, std::memory_order_relaxed);
+
+	    if(serving.load(std::memory_order_acquire) != ticket)
+		wait_turn(ticket);
+	};
+
+	    /// unlock the mutex, granting it to the next thread in order
+	void unlock() { serving.store(serving.load(std::memory_order_relaxed) + 1, std::memory_order_release); };
+
+	    /// acquire the mutex if available without waiting
+
+	    /// \return true if lock is acquired false if mutex was already locked
+	bool try_lock()
+	{
+	    unsigned int current = serving.load(std::memory_order_acquire);
+	    unsigned int ticket = current;
+
+	    return next.compare_exchange_strong(ticket, current + 1, std::memory_order_acquire, std::memory_order_relaxed);
+	};
+
+    private:
+	std::atomic<unsigned int> next;     ///< next ticket to give
+	std::atomic<unsigned int> serving;  ///< ticket of the thread holding the mutex
+
+	void wait_turn(unsigned int ticket);
+    };
+
+} // end of namespace
+
+#endif
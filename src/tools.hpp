@@ -32,9 +32,13 @@
     // C system headers
 extern "C"
 {
+#if HAVE_SCHED_H
+#include <sched.h>
+#endif
 }
     // C++ standard headers
 #include <sstream>
+#include <atomic>
 
     // libthreadar headers
 
@@ -47,6 +51,36 @@ namespace libthreadar
 	return tmp.str();
     }
 
+	/// tell the CPU the caller is busy waiting for a memory location to change
+    inline void tools_cpu_relax()
+    {
+#if defined(__i386__) || defined(__x86_64__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield" ::: "memory");
+#else
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+    }
+
+	/// to be called at each round of a busy waiting loop
+
+	/// \param[in,out] round number of rounds already spent waiting, to be set to zero before the loop
+	/// \note the first rounds only relax the CPU, the next ones yield the CPU to other threads
+	/// so the thread we wait for can run even on an overloaded system
+    inline void tools_spin_pause(unsigned int & round)
+    {
+	static const unsigned int relax_rounds = 128;
+
+	if(round < relax_rounds)
+	{
+	    ++round;
+	    tools_cpu_relax();
+	}
+	else
+	    sched_yield();
+    }
+
 } // end of namespace
 
 #endif
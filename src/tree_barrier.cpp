@@ -0,0 +1,126 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <new>
+
+    // libthreadar headers
+
+    // this module's header
+#include "tree_barrier.hpp"
+
+using namespace std;
+
+namespace libthreadar
+{
+
+    tree_barrier::tree_barrier(unsigned int num, unsigned int spin, unsigned int fan_in): val(num), spin_budget(spin), fan(fan_in), phase(0), sleepers(0)
+    {
+	unsigned int total = 0;
+	unsigned int width = num;
+	unsigned int start = 0;
+
+	if(num < 1)
+	    throw exception_range("zero given as argument to tree_barrier");
+	if(fan_in < 2)
+	    throw exception_range("tree_barrier fan in must be at least 2");
+
+	    // counting the nodes, level by level
+
+	do
+	{
+	    width = (width + fan - 1) / fan;
+	    total += width;
+	}
+	while(width > 1);
+
+	nodes.reset(new (nothrow) node[total]);
+	if(! nodes)
+	    throw exception_memory();
+
+	    // linking each level to the next one, 'width' being the number
+	    // of participants or nodes of the level below the one built
+
+	width = num;
+	do
+	{
+	    unsigned int level = (width + fan - 1) / fan;
+	    unsigned int next = start + level;
+
+	    for(unsigned int i = 0; i < level; ++i)
+	    {
+		node & cur = nodes[start + i];
+
+		cur.expected = (i + 1) * fan <= width ? fan : width - i * fan;
+		cur.remaining.store(cur.expected, memory_order_relaxed);
+		cur.parent = level > 1 ? next + i / fan : start + i;
+	    }
+
+	    start = next;
+	    width = level;
+	}
+	while(width > 1);
+
+	if(start != total)
+	    throw THREADAR_BUG;
+    }
+
+    bool tree_barrier::wait(unsigned int participant)
+    {
+	unsigned int index = participant / fan;
+	int current;
+
+	if(participant >= val)
+	    throw exception_range("participant index out of range for tree_barrier");
+
+	    // the phase cannot change before we have decremented our leaf
+	current = phase.load(memory_order_relaxed);
+
+	while(nodes[index].remaining.fetch_sub(1, memory_order_acq_rel) == 1)
+	{
+	    node & cur = nodes[index];
+
+		// last arrived at this node, no other thread touches
+		// it before we change the phase
+	    cur.remaining.store(cur.expected, memory_order_relaxed);
+
+	    if(cur.parent == index)
+	    {
+		spin_barrier::next_phase(phase, sleepers);
+		return true;
+	    }
+	    index = cur.parent;
+	}
+
+	spin_barrier::wait_phase(phase, current, sleepers, spin_budget);
+	return false;
+    }
+
+} // end of namespace
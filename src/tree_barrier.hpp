@@ -0,0 +1,131 @@
+/*********************************************************************/
+// libthreadar - is a library providing several C++ classes to work with threads
+// Copyright (C) 2014-2025 Denis Corbin
+//
+// This file is part of libthreadar
+//
+//  libthreadar is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Lesser General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  libhtreadar is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public License
+//  along with libthreadar.  If not, see <http://www.gnu.org/licenses/>
+//
+//----
+//  to contact the author: dar.linux@free.fr
+/*********************************************************************/
+
+
+#ifndef LIBTHREADAR_TREE_BARRIER_HPP
+#define LIBTHREADAR_TREE_BARRIER_HPP
+
+    /// \file tree_barrier.hpp
+    /// \brief defines the tree_barrier class, a combining tree barrier for many threads
+
+#include "config.h"
+
+    // C system headers
+extern "C"
+{
+}
+    // C++ standard headers
+#include <atomic>
+#include <memory>
+
+    // libthreadar headers
+#include "exceptions.hpp"
+#include "spin_barrier.hpp"
+
+namespace libthreadar
+{
+
+	/// Class tree_barrier is a spin_barrier which arrival counter is split over a tree
+
+	/// With many threads, the single counter of spin_barrier becomes a cache line all
+	/// threads fight for. Here each participant decrements the counter of a leaf shared with
+	/// at most fan_in - 1 other participants, the last one arriving at a node climbing to its
+	/// parent node, up to the root where the last thread releases all others the same way
+	/// spin_barrier does (spinning, then sleeping with futex).
+	///
+	/// Each participant identifies itself when calling wait(), which for parallel compute
+	/// phases is usually the worker index.
+	///
+	/// \note under about 32 threads spin_barrier is as fast and does not need participant indexes
+	/// \note wait() is not a cancellation point
+    class tree_barrier
+    {
+    public:
+	    /// default number of participants or child nodes sharing a node
+	static const unsigned int default_fan_in = 4;
+
+	    /// constructor
+
+	    /// \param[in] num is the number of threads to synchronize
+	    /// \param[in] spin number of rounds a thread spins before sleeping (see spin_barrier)
+	    /// \param[in] fan_in number of participants sharing a leaf and of nodes sharing a parent node,
+	    /// at least 2
+	tree_barrier(unsigned int num, unsigned int spin = spin_barrier::default_spin, unsigned int fan_in = default_fan_in);
+
+	    /// no copy constructor
+	tree_barrier(const tree_barrier & ref) = delete;
+
+	    /// no move constructor
+	tree_barrier(tree_barrier && ref) = delete;
+
+	    /// no assignment operator
+	tree_barrier & operator = (const tree_barrier & ref) = delete;
+
+	    /// no move operator
+	tree_barrier & operator = (tree_barrier && ref) = delete;
+
+	    /// destructor
+
+	    /// \note A barrier object must not be destroyed if some thread are waiting on it
+	~tree_barrier() = default;
+
+	    /// suspend the calling thread up to the time all participants have called wait()
+
+	    /// \param[in] participant index of the caller, from 0 to num - 1, each participant
+	    /// must use its own index at each phase
+	    /// \return true for exactly one of the threads, the last to arrive
+	bool wait(unsigned int participant);
+
+	    /// return the barrier size
+	unsigned int get_count() const { return val; };
+
+	    /// return the number of rounds threads spin before sleeping
+	unsigned int get_spin() const { return spin_budget; };
+
+	    /// return the number of participants or nodes sharing a node
+	unsigned int get_fan_in() const { return fan; };
+
+    private:
+	    /// a node of the tree, on its own cache line
+	struct node
+	{
+	    std::atomic<unsigned int> remaining; ///< number of participants or child nodes still expected
+	    unsigned int expected;               ///< value remaining is reset to once reached zero
+	    unsigned int parent;                 ///< index of the parent node, or of the node itself for the root
+	    char pad[64 - sizeof(std::atomic<unsigned int>) - 2*sizeof(unsigned int)];
+
+	    node(): remaining(0), expected(0), parent(0) {};
+	};
+
+	unsigned int val;                    ///< number of participants
+	unsigned int spin_budget;            ///< number of spinning rounds before sleeping
+	unsigned int fan;                    ///< fan in of the tree
+	std::unique_ptr<node[]> nodes;       ///< leaves first, then each level up to the root
+	std::atomic<int> phase;              ///< incremented each time the threads are released, futex word
+	std::atomic<unsigned int> sleepers;  ///< number of threads sleeping on phase
+	char pad[64 - sizeof(std::atomic<int>) - sizeof(std::atomic<unsigned int>)];
+    };
+
+} // end of namespace
+
+#endif